@@ -38,15 +38,44 @@
 #include <algorithm>
 #include <vector>
 #include <queue>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
 #include <cstring>
 #include <cstdlib>
+#include <cfloat>
+#include <climits>
+#include <cmath>
 #include <ctime>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <gtkmm.h>
 #include <gtkmm/switch.h>
+#if !defined(SHL_IMAGE_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64))
+ #define SHL_IMAGE_USE_SSE2
+ #include <emmintrin.h>
+#endif
+// The SSE4.1/AVX2 kernels are compiled with the target attribute and selected
+// at runtime, so the header does not require -msse4.1 or -mavx2
+#if defined(SHL_IMAGE_USE_SSE2) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+ #define SHL_IMAGE_USE_RUNTIME_DISPATCH
+ #include <immintrin.h>
+#endif
+// The built-in colormap tables take about 8.4M constexpr operations (GCC 12).
+// GCC (default -fconstexpr-ops-limit=2^33) generates them at compile time.
+// Clang stops at 1M steps (-fconstexpr-steps) and the limits of the other
+// compilers are not verified, so they generate the tables once at runtime.
+// Define SHL_IMAGE_COLORMAP_RUNTIME_TABLES to do the same with GCC
+#if !defined(SHL_IMAGE_COLORMAP_RUNTIME_TABLES) && \
+    (!defined(__GNUC__) || defined(__clang__))
+ #define SHL_IMAGE_COLORMAP_RUNTIME_TABLES
+#endif
 
 
 // Namespace -------------------------------------------------------------------
@@ -365,6 +394,296 @@ namespace base  // shl::gtk::base
     friend class WindowBase;
   };
 
+  // ===========================================================================
+  //  WorkerPool class
+  // ===========================================================================
+  // A small pool of threads running the indexed tasks in parallel. The calling
+  // thread also runs the tasks and run() returns when all of them are done.
+  // The threads are created on demand up to the thread number setting. While
+  // the pool is used by another thread, run() runs the tasks by itself
+  // instead of waiting (the UI thread is never blocked by a background job)
+  //
+  class WorkerPool
+  {
+  public:
+    // -------------------------------------------------------------------------
+    // WorkerPool constructor
+    // -------------------------------------------------------------------------
+    WorkerPool() :
+      m_generation(0), m_task_num(0), m_next_task(0), m_remaining_task(0),
+      m_func(nullptr), m_quit(false)
+    {
+    }
+    // -------------------------------------------------------------------------
+    // WorkerPool destructor
+    // -------------------------------------------------------------------------
+    virtual ~WorkerPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        m_start_cond.notify_all();
+      }
+      for (auto thread : m_threads)
+      {
+        thread->join();
+        delete thread;
+      }
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // run
+    // -------------------------------------------------------------------------
+    // Calls in_func(0) ... in_func(in_task_num - 1) using up to in_thread_num
+    // threads (including the calling thread)
+    //
+    void run(int in_task_num, int in_thread_num, const std::function<void(int)> &in_func)
+    {
+      if (in_task_num <= 0)
+        return;
+      if (in_thread_num > in_task_num)
+        in_thread_num = in_task_num;
+      if (in_thread_num <= 1)
+      {
+        for (int i = 0; i < in_task_num; i++)
+          in_func(i);
+        return;
+      }
+      std::unique_lock<std::mutex> run_lock(m_run_mutex, std::try_to_lock);
+      if (run_lock.owns_lock() == false)
+      {
+        for (int i = 0; i < in_task_num; i++)
+          in_func(i);
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while ((int )m_threads.size() < in_thread_num - 1)
+          m_threads.push_back(new std::thread(thread_func, this));
+        m_func = &in_func;
+        m_task_num = in_task_num;
+        m_remaining_task = in_task_num;
+        m_generation++;
+        m_next_task.store((uint64_t )m_generation << 32);
+        m_start_cond.notify_all();
+      }
+      process_tasks(m_generation, in_task_num, &in_func);
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done_cond.wait(lock, [this] { return m_remaining_task == 0; });
+      m_func = nullptr;
+    }
+
+  protected:
+    // -------------------------------------------------------------------------
+    // process_tasks
+    // -------------------------------------------------------------------------
+    // The job (in_generation, in_task_num and in_func) is the snapshot taken
+    // under m_mutex, so a worker woken for an older job never reads the
+    // members of a newer one
+    //
+    void process_tasks(unsigned int in_generation, int in_task_num,
+                       const std::function<void(int)> *in_func)
+    {
+      int done_num = 0;
+      int i;
+      while (claim_task(in_generation, in_task_num, &i))
+      {
+        (*in_func)(i);
+        done_num++;
+      }
+      if (done_num == 0)
+        return;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_remaining_task -= done_num;
+      if (m_remaining_task == 0)
+        m_done_cond.notify_all();
+    }
+    // -------------------------------------------------------------------------
+    // claim_task
+    // -------------------------------------------------------------------------
+    // m_next_task holds the generation in the upper 32 bits and the next task
+    // index in the lower ones. The index is taken only while the generation
+    // matches, so a stale worker can neither run a task of a newer job nor
+    // consume its index
+    //
+    bool claim_task(unsigned int in_generation, int in_task_num, int *out_index)
+    {
+      uint64_t v = m_next_task.load(std::memory_order_acquire);
+      while (true)
+      {
+        if ((unsigned int )(v >> 32) != in_generation)
+          return false;
+        int index = (int )(uint32_t )v;
+        if (index >= in_task_num)
+          return false;
+        if (m_next_task.compare_exchange_weak(v, v + 1, std::memory_order_acq_rel,
+                                              std::memory_order_acquire))
+        {
+          *out_index = index;
+          return true;
+        }
+      }
+    }
+    // -------------------------------------------------------------------------
+    // thread_func
+    // -------------------------------------------------------------------------
+    static void thread_func(WorkerPool *in_obj)
+    {
+      unsigned int generation = 0;
+      while (true)
+      {
+        int task_num;
+        const std::function<void(int)> *func;
+        {
+          std::unique_lock<std::mutex> lock(in_obj->m_mutex);
+          in_obj->m_start_cond.wait(lock, [in_obj, generation]
+          {
+            return in_obj->m_quit || in_obj->m_generation != generation;
+          });
+          if (in_obj->m_quit)
+            return;
+          generation = in_obj->m_generation;
+          if (in_obj->m_remaining_task == 0)
+            continue;
+          task_num = in_obj->m_task_num;
+          func = in_obj->m_func;
+        }
+        in_obj->process_tasks(generation, task_num, func);
+      }
+    }
+
+  private:
+    // member variables --------------------------------------------------------
+    std::vector<std::thread *> m_threads;
+    std::mutex m_run_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_start_cond;
+    std::condition_variable m_done_cond;
+    unsigned int m_generation;
+    int m_task_num;
+    std::atomic<uint64_t> m_next_task;  // generation << 32 | next task index
+    int m_remaining_task;
+    const std::function<void(int)> *m_func;
+    bool m_quit;
+  };
+
+  // ===========================================================================
+  //  TaskThread class
+  // ===========================================================================
+  // A thread running one task at a time in the background. post() is rejected
+  // while the previous task is running. The thread is created on demand
+  //
+  class TaskThread
+  {
+  public:
+    // -------------------------------------------------------------------------
+    // TaskThread constructor
+    // -------------------------------------------------------------------------
+    TaskThread() :
+      m_thread(nullptr), m_is_busy(false), m_quit(false)
+    {
+    }
+    // -------------------------------------------------------------------------
+    // TaskThread destructor
+    // -------------------------------------------------------------------------
+    virtual ~TaskThread()
+    {
+      stop();
+    }
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // post
+    // -------------------------------------------------------------------------
+    // Starts in_task on the thread. Returns false if a task is running
+    //
+    bool post(std::function<void()> in_task)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_is_busy || m_quit)
+        return false;
+      if (m_thread == nullptr)
+        m_thread = new std::thread(thread_func, this);
+      m_task = std::move(in_task);
+      m_is_busy = true;
+      m_start_cond.notify_all();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // is_busy
+    // -------------------------------------------------------------------------
+    bool is_busy()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_is_busy;
+    }
+    // -------------------------------------------------------------------------
+    // wait
+    // -------------------------------------------------------------------------
+    // Waits for the running task
+    //
+    void wait()
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done_cond.wait(lock, [this] { return m_is_busy == false; });
+    }
+    // -------------------------------------------------------------------------
+    // stop
+    // -------------------------------------------------------------------------
+    // Waits for the running task and terminates the thread
+    //
+    void stop()
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        m_start_cond.notify_all();
+      }
+      if (m_thread != nullptr)
+      {
+        m_thread->join();
+        delete m_thread;
+        m_thread = nullptr;
+      }
+    }
+
+  protected:
+    // -------------------------------------------------------------------------
+    // thread_func
+    // -------------------------------------------------------------------------
+    static void thread_func(TaskThread *in_obj)
+    {
+      while (true)
+      {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lock(in_obj->m_mutex);
+          in_obj->m_start_cond.wait(lock, [in_obj]
+          {
+            return in_obj->m_quit || in_obj->m_is_busy;
+          });
+          if (in_obj->m_is_busy == false)
+            return;
+          task = std::move(in_obj->m_task);
+          in_obj->m_task = nullptr;
+        }
+        task();
+        std::lock_guard<std::mutex> lock(in_obj->m_mutex);
+        in_obj->m_is_busy = false;
+        in_obj->m_done_cond.notify_all();
+      }
+    }
+
+  private:
+    // member variables --------------------------------------------------------
+    std::thread *m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_start_cond;
+    std::condition_variable m_done_cond;
+    std::function<void()> m_task;
+    bool m_is_busy;
+    bool m_quit;
+  };
+
   // ===========================================================================
   //  BackgroundApp class
   // ===========================================================================
@@ -376,9 +695,44 @@ namespace base  // shl::gtk::base
     // -------------------------------------------------------------------------
     ~BackgroundApp() override
     {
+      get_worker_pool_ptr().store(nullptr);
       SHL_DBG_OUT("BackgroundApp was deleted");
     }
 
+    // static functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // get_worker_pool
+    // -------------------------------------------------------------------------
+    // Returns the worker pool of the running BackgroundApp (nullptr if the
+    // application is not created yet)
+    //
+    static WorkerPool *get_worker_pool()
+    {
+      return get_worker_pool_ptr().load();
+    }
+    // -------------------------------------------------------------------------
+    // get_worker_thread_num
+    // -------------------------------------------------------------------------
+    static int get_worker_thread_num()
+    {
+      int num = get_worker_thread_num_setting().load();
+      if (num > 0)
+        return num;
+      num = (int )std::thread::hardware_concurrency();
+      if (num > MAX_AUTO_WORKER_THREAD_NUM)
+        num = MAX_AUTO_WORKER_THREAD_NUM;
+      return (num < 1) ? 1 : num;
+    }
+    // -------------------------------------------------------------------------
+    // set_worker_thread_num
+    // -------------------------------------------------------------------------
+    // 0 : the number of the CPU cores (up to 8), 1 : no worker threads
+    //
+    static void set_worker_thread_num(int in_num)
+    {
+      get_worker_thread_num_setting().store(in_num < 0 ? 0 : in_num);
+    }
+
   protected:
     // -------------------------------------------------------------------------
     // BackgroundApp constructor
@@ -388,6 +742,7 @@ namespace base  // shl::gtk::base
                              Gio::APPLICATION_NON_UNIQUE),
                              m_quit(false)
     {
+      get_worker_pool_ptr().store(&m_worker_pool);
     }
 
     // Member functions --------------------------------------------------------
@@ -646,6 +1001,28 @@ namespace base  // shl::gtk::base
     std::condition_variable m_window_cond;
     std::mutex  m_window_mutex;
     bool m_quit;
+    WorkerPool m_worker_pool;
+
+    // Constants ---------------------------------------------------------------
+    static constexpr int MAX_AUTO_WORKER_THREAD_NUM = 8;
+
+    // static functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // get_worker_pool_ptr
+    // -------------------------------------------------------------------------
+    static std::atomic<WorkerPool *> &get_worker_pool_ptr()
+    {
+      static std::atomic<WorkerPool *> s_worker_pool(nullptr);
+      return s_worker_pool;
+    }
+    // -------------------------------------------------------------------------
+    // get_worker_thread_num_setting
+    // -------------------------------------------------------------------------
+    static std::atomic<int> &get_worker_thread_num_setting()
+    {
+      static std::atomic<int> s_thread_num(0);
+      return s_thread_num;
+    }
 
     // friend classes ----------------------------------------------------------
     friend class BackgroundAppRunner;
@@ -883,6 +1260,34 @@ namespace base  // shl::gtk::base
       return m_app_runner->get_window_num();
     }
     // -------------------------------------------------------------------------
+    // set_conversion_thread_num
+    // -------------------------------------------------------------------------
+    /**
+     * Sets the number of the threads used to convert the large images for
+     * the display. The threads are shared by all of the windows and live as
+     * long as the background application.
+     *
+     * @param in_num    The number of the threads (including the UI thread)
+     *  - 0 : The number of the CPU cores (up to 8, default)
+     *  - 1 : Converts the images on the UI thread only
+     */
+    static void set_conversion_thread_num(int in_num)
+    {
+      BackgroundApp::set_worker_thread_num(in_num);
+    }
+    // -------------------------------------------------------------------------
+    // get_conversion_thread_num
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the number of the threads used to convert the images.
+     *
+     * @return The number of the threads (including the UI thread)
+     */
+    static int get_conversion_thread_num()
+    {
+      return BackgroundApp::get_worker_thread_num();
+    }
+    // -------------------------------------------------------------------------
     // show_window
     // -------------------------------------------------------------------------
     /**
@@ -911,6 +1316,8 @@ namespace base  // shl::gtk::base
     {
       if (back_app_get_window() == nullptr)
         return;
+      if (update_window_by_frame_clock())
+        return;
       m_app_runner->update_window(this);
     }
     // -------------------------------------------------------------------------
@@ -999,6 +1406,17 @@ namespace base  // shl::gtk::base
     virtual bool is_window_object_null() = 0;
     virtual void update_window() = 0;
     virtual const char *get_default_window_title() = 0;
+    // -------------------------------------------------------------------------
+    // update_window_by_frame_clock
+    // -------------------------------------------------------------------------
+    // Called by update() on the calling thread. Returns true if the window
+    // picks up the update by itself on the next frame of the display (nothing
+    // is posted to the BackgroundApp)
+    //
+    virtual bool update_window_by_frame_clock()
+    {
+      return false;
+    }
 
     // -------------------------------------------------------------------------
     // WindowBase constructor
@@ -1172,12 +1590,30 @@ namespace image     // shl::gtk::image
       COLORMAP_BlueDarkYellow,
       COLORMAP_GreenRed,
 
+      // Registered at runtime (see register_colormap())
+      COLORMAP_CUSTOM = 256,
+
       COLORMAP_ANY = 32765,
 
       // For Internal use only
       COLORMAP_END = -1
     };
 
+    static constexpr size_t COLORMAP_CACHE_MAX_NUM = 64;
+    static constexpr unsigned int BUILTIN_COLOR_NUM = 256;
+    static constexpr unsigned int CUSTOM_LUT_MAX_COLOR_NUM = 65536;
+
+    // Typedefs ----------------------------------------------------------------
+    typedef std::shared_ptr<const uint8_t> ColormapLUT;
+    struct ControlPoint
+    {
+      double ratio;       // Position in the colormap [0, 1]
+      uint8_t R;
+      uint8_t G;
+      uint8_t B;
+      bool is_diverging;  // Msh interpolation to the next point (linear RGB if false)
+    };
+
     // Static Functions --------------------------------------------------------
     // -------------------------------------------------------------------------
     // get_colormap
@@ -1188,94 +1624,191 @@ namespace image     // shl::gtk::image
                              unsigned int in_multi_num = 1,
                              double in_gain = 1.0, int in_offset = 0)
     {
-      unsigned int i, index, num, total, offset, num_all;
-      std::vector<ColormapData> colormap_data;
-      double ratio0, ratio1, offset_ratio;
-
-      get_multi_colormap_data(in_index, in_multi_num, colormap_data);
-      if (colormap_data.size() < 2 || in_gain <= 0.0 || in_color_num == 0)
-      {
-        clear_colormap(in_color_num, out_colormap);
+      if (in_color_num == 0)
         return;
+      ColormapLUT lut = get_shared_colormap(in_index, in_color_num,
+                                            in_multi_num, in_gain, in_offset);
+      std::memcpy(out_colormap, lut.get(), in_color_num * 3);
+    }
+    // -------------------------------------------------------------------------
+    // get_shared_colormap
+    // -------------------------------------------------------------------------
+    // Returns the RGB LUT (in_color_num * 3 bytes) for the parameters.
+    // The LUTs are shared by the whole process and each parameter set is
+    // generated only once while it stays in the cache (the least recently
+    // used one is dropped when COLORMAP_CACHE_MAX_NUM is exceeded).
+    // The returned LUT is immutable and can be held by any thread.
+    // The default LUTs of the built-in colormaps are not generated at all
+    // (see get_builtin_colormap())
+    //
+    static ColormapLUT get_shared_colormap(ColormapIndex in_index,
+                                           unsigned int in_color_num,
+                                           unsigned int in_multi_num = 1,
+                                           double in_gain = 1.0, int in_offset = 0)
+    {
+      if (in_color_num == BUILTIN_COLOR_NUM && in_multi_num == 1 &&
+          in_gain == 1.0 && in_offset == 0)
+      {
+        const uint8_t *builtin = get_builtin_colormap(in_index);
+        if (builtin != nullptr)
+          return ColormapLUT(ColormapLUT(), builtin); // Not owned (static data)
       }
-
-      total = 0;
-      index = 0;
-      num = 0;
-      offset_ratio = (double) in_offset / (double) in_color_num;
-      ratio0 = colormap_data[index].ratio / in_gain - offset_ratio;
-      if (ratio0 > 0)
+      if (in_index >= COLORMAP_CUSTOM && in_multi_num == 1 &&
+          in_gain == 1.0 && in_offset == 0)
       {
-        num = (int) ((double) in_color_num * ratio0);
-        for (i = 0; i < num; i++)
-        {
-          out_colormap[0] = colormap_data[index].rgb.R;
-          out_colormap[1] = colormap_data[index].rgb.G;
-          out_colormap[2] = colormap_data[index].rgb.B;
-          out_colormap += 3;
-          total++;
-        }
+        // The registered full LUT is shared as is
+        std::shared_ptr<const CustomColormap> custom = find_custom_colormap(in_index);
+        if (custom && custom->lut && custom->lut_color_num == in_color_num)
+          return custom->lut;
       }
 
-      const uint8_t *rgb0;
-      const uint8_t *rgb1 = nullptr;
-      while (index + 1 < colormap_data.size())
+      ColormapCache *cache = get_colormap_cache();
+      const ColormapKey key = {in_index, in_color_num, in_multi_num,
+                               in_gain, in_offset};
       {
-        ratio1 = colormap_data[index + 1].ratio / in_gain - offset_ratio;
-        rgb0 = (const uint8_t *) &(colormap_data[index].rgb);
-        rgb1 = (const uint8_t *) &(colormap_data[index + 1].rgb);
-        if (ratio1 > 0)
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        for (auto &entry : cache->entries)
         {
-          if (ratio1 == 1.0)  // <- this is to absorb calculation error
-            num_all = in_color_num - total;
-          else
-            num_all = (int) (ratio1 * in_color_num) -
-                      (int) (ratio0 * in_color_num);  // Do not use (ratio1 - ratio0) * in_color_num
-          if (ratio0 < 0.0)
-          {
-            if (ratio1 < 1.0)
-              num = (unsigned int) ((double) in_color_num * ratio1);
-            else
-              num = in_color_num;
-            offset = (int) ((0.0 - ratio0) * (double) in_color_num);
-          } else
-          {
-            num = num_all;
-            offset = 0;
-          }
-          if (num > in_color_num - total)
-            num = in_color_num - total;
-          switch (colormap_data[index].type)
+          if (entry.key == key)
           {
-            case CMType_Linear:
-              calc_linear_colormap(rgb0, rgb1, offset, num_all,
-                                   num, out_colormap);
-              break;
-            case CMType_Diverging:
-              calc_diverging_colormap(rgb0, rgb1, offset, num_all,
-                                      num, out_colormap);
-              break;
+            entry.last_used = ++cache->use_count;
+            return entry.lut;
           }
         }
-        ratio0 = ratio1;
-        out_colormap += num * 3;
-        total += num;
-        index++;
-        if (total == in_color_num)
-          break;
       }
 
-      if (total < in_color_num)
+      // Generate the LUT outside of the lock so that the other windows are
+      // not blocked by the Msh interpolation
+      auto buffer = std::make_shared<std::vector<uint8_t>>((size_t )in_color_num * 3);
+      calc_colormap(in_index, in_color_num, buffer->data(),
+                    in_multi_num, in_gain, in_offset);
+      ColormapLUT lut(buffer, buffer->data());
+
+      std::lock_guard<std::mutex> lock(cache->mutex);
+      for (auto &entry : cache->entries)
       {
-        num = in_color_num - total;
-        for (i = 0; i < num; i++)
+        if (entry.key == key) // Another thread generated it in the meantime
         {
-          out_colormap[0] = rgb1[0];
-          out_colormap[1] = rgb1[1];
-          out_colormap[2] = rgb1[2];
-          out_colormap += 3;
+          entry.last_used = ++cache->use_count;
+          return entry.lut;
         }
       }
+      if (cache->entries.size() >= COLORMAP_CACHE_MAX_NUM)
+      {
+        auto oldest = std::min_element(cache->entries.begin(), cache->entries.end(),
+                                       [](const ColormapCacheEntry &a,
+                                          const ColormapCacheEntry &b)
+                                       { return a.last_used < b.last_used; });
+        cache->entries.erase(oldest);
+      }
+      cache->entries.push_back({key, lut, ++cache->use_count});
+      return lut;
+    }
+    // -------------------------------------------------------------------------
+    // get_builtin_colormap
+    // -------------------------------------------------------------------------
+    // Returns the BUILTIN_COLOR_NUM colors LUT (gain 1.0, offset 0, no multi)
+    // of the built-in colormap, or nullptr if in_index is not a built-in one.
+    // The LUTs are generated at compile time and live in the read-only data
+    //
+    static const uint8_t *get_builtin_colormap(ColormapIndex in_index)
+    {
+      if (in_index < COLORMAP_GrayScale || in_index > BUILTIN_COLORMAP_LAST)
+        return nullptr;
+      return get_builtin_colormaps().lut[in_index - COLORMAP_GrayScale];
+    }
+    // -------------------------------------------------------------------------
+    // clear_colormap_cache
+    // -------------------------------------------------------------------------
+    static void clear_colormap_cache()
+    {
+      ColormapCache *cache = get_colormap_cache();
+      std::lock_guard<std::mutex> lock(cache->mutex);
+      cache->entries.clear();
+    }
+    // -------------------------------------------------------------------------
+    // register_colormap
+    // -------------------------------------------------------------------------
+    // Registers the custom colormap defined by the control points and returns
+    // its index (COLORMAP_CUSTOM or above). The index can be used as the
+    // built-in ones (e.g. Data::set_colormap_index()) and the generated LUTs
+    // are shared by all the views through get_shared_colormap().
+    // The ratios have to be strictly increasing in [0, 1] (2 points or more).
+    // Registering the same definition again returns the same index.
+    // Returns COLORMAP_NOT_SPECIFIED if the definition is invalid or all the
+    // indices are used
+    //
+    static ColormapIndex register_colormap(const ControlPoint *in_points, size_t in_point_num)
+    {
+      if (in_points == nullptr || in_point_num < 2 ||
+          in_point_num > CUSTOM_LUT_MAX_COLOR_NUM)
+        return COLORMAP_NOT_SPECIFIED;
+      auto custom = std::make_shared<CustomColormap>();
+      custom->points.resize(in_point_num);
+      for (size_t i = 0; i < in_point_num; i++)
+      {
+        const ControlPoint &point = in_points[i];
+        if ((point.ratio >= 0.0 && point.ratio <= 1.0) == false)  // NaN is rejected too
+          return COLORMAP_NOT_SPECIFIED;
+        if (i != 0 && point.ratio <= in_points[i - 1].ratio)
+          return COLORMAP_NOT_SPECIFIED;
+        custom->points[i] = {COLORMAP_NOT_SPECIFIED, point.ratio,
+                             point.is_diverging ? CMType_Diverging : CMType_Linear,
+                             {point.R, point.G, point.B}};
+      }
+      return add_custom_colormap(custom);
+    }
+    // -------------------------------------------------------------------------
+    // register_colormap
+    // -------------------------------------------------------------------------
+    // Registers the custom colormap given as the RGB LUT (in_color_num * 3
+    // bytes, 2 - CUSTOM_LUT_MAX_COLOR_NUM colors) and returns its index.
+    // The LUT is copied and is shared as is when in_color_num colors are
+    // requested without multi/gain/offset. The other sizes pick the nearest
+    // entries (the first and the last colors are kept), so that the discrete
+    // palettes keep their edges
+    //
+    static ColormapIndex register_colormap(const uint8_t *in_lut, unsigned int in_color_num)
+    {
+      if (in_lut == nullptr || in_color_num < 2 ||
+          in_color_num > CUSTOM_LUT_MAX_COLOR_NUM)
+        return COLORMAP_NOT_SPECIFIED;
+      auto buffer = std::make_shared<std::vector<uint8_t>>(in_lut, in_lut + (size_t )in_color_num * 3);
+      auto custom = std::make_shared<CustomColormap>();
+      custom->lut = ColormapLUT(buffer, buffer->data());
+      custom->lut_color_num = in_color_num;
+      return add_custom_colormap(custom);
+    }
+    // -------------------------------------------------------------------------
+    // is_custom_colormap
+    // -------------------------------------------------------------------------
+    static bool is_custom_colormap(ColormapIndex in_index)
+    {
+      return (bool )find_custom_colormap(in_index);
+    }
+    // -------------------------------------------------------------------------
+    // calc_colormap
+    // -------------------------------------------------------------------------
+    // Generates the LUT without the cache
+    //
+    static constexpr void calc_colormap(ColormapIndex in_index,
+                                        unsigned int in_color_num,
+                                        uint8_t *out_colormap,
+                                        unsigned int in_multi_num = 1,
+                                        double in_gain = 1.0, int in_offset = 0)
+    {
+      if (__builtin_is_constant_evaluated() == false && in_index >= COLORMAP_CUSTOM)
+      {
+        calc_custom_colormap(in_index, in_color_num, out_colormap,
+                             in_multi_num, in_gain, in_offset);
+        return;
+      }
+      int data_pos = find_colormap_data(in_index);
+      unsigned int single_num = 0;
+      if (data_pos >= 0)
+        single_num = get_colormap_data_num(data_pos);
+      calc_colormap(&COLORMAP_DATA[data_pos >= 0 ? data_pos : 0], single_num,
+                    in_color_num, out_colormap, in_multi_num, in_gain, in_offset);
     }
     // -------------------------------------------------------------------------
     // get_monomap
@@ -1313,20 +1846,19 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // clear_colormap
     // -------------------------------------------------------------------------
-    static void clear_colormap(unsigned int in_color_num, uint8_t *out_colormap)
+    static constexpr void clear_colormap(unsigned int in_color_num, uint8_t *out_colormap)
     {
-      if (in_color_num == 0)
-        return;
-      std::memset(out_colormap, 0, in_color_num * 3);
+      for (unsigned int i = 0; i < in_color_num * 3; i++)
+        out_colormap[i] = 0;
     }
     // -------------------------------------------------------------------------
     // calc_linear_colormap
     // -------------------------------------------------------------------------
-    static void calc_linear_colormap(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
-                                     unsigned int in_offset, unsigned int in_color_num_all,
-                                     unsigned int in_map_num, uint8_t *out_colormap)
+    static constexpr void calc_linear_colormap(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
+                                               unsigned int in_offset, unsigned int in_color_num_all,
+                                               unsigned int in_map_num, uint8_t *out_colormap)
     {
-      double interp, k, v;
+      double interp = 0, k = 0, v = 0;
 
       k = 1.0 / (double) (in_color_num_all - 1.0);
       for (unsigned int i = 0; i < in_map_num; i++)
@@ -1347,11 +1879,21 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // calc_diverging_colormap
     // -------------------------------------------------------------------------
-    static void calc_diverging_colormap(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
-                                        unsigned int in_offset, unsigned int in_color_num_all,
-                                        unsigned int in_map_num, uint8_t *out_color_map)
+    static constexpr void calc_diverging_colormap(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
+                                                  unsigned int in_offset, unsigned int in_color_num_all,
+                                                  unsigned int in_map_num, uint8_t *out_color_map)
     {
-      double interp, k;
+      double interp = 0, k = 0;
+
+      // The LUTs larger than the built-in ones use the batched float version
+      // (the LUTs up to BUILTIN_COLOR_NUM colors are the same as before)
+      if (__builtin_is_constant_evaluated() == false &&
+          in_color_num_all > BUILTIN_COLOR_NUM)
+      {
+        calc_diverging_colormap_batched(in_rgb0, in_rgb1, in_offset,
+                                        in_color_num_all, in_map_num, out_color_map);
+        return;
+      }
 
       k = 1.0 / (double) (in_color_num_all - 1.0);
       for (unsigned int i = 0; i < in_map_num; i++)
@@ -1364,17 +1906,36 @@ namespace image     // shl::gtk::image
       }
     }
     // -------------------------------------------------------------------------
+    // calc_diverging_colormap_batched
+    // -------------------------------------------------------------------------
+    static void calc_diverging_colormap_batched(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
+                                                unsigned int in_offset,
+                                                unsigned int in_color_num_all,
+                                                unsigned int in_map_num, uint8_t *out_color_map)
+    {
+      std::vector<float> interp(in_map_num);
+      double k = 1.0 / (double) (in_color_num_all - 1.0);
+      for (unsigned int i = 0; i < in_map_num; i++)
+      {
+        unsigned int t = i + in_offset;
+        if (t >= in_color_num_all) // Sanity is_valid
+          t = in_color_num_all - 1;
+        interp[i] = (float) ((double) t * k);
+      }
+      interpolate_colors(in_rgb0, in_rgb1, interp.data(), in_map_num, out_color_map);
+    }
+    // -------------------------------------------------------------------------
     // interpolate_color
     // -------------------------------------------------------------------------
-    static void interpolate_color(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
-                                  double in_interp, uint8_t *out_rgb)
+    static constexpr void interpolate_color(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
+                                            double in_interp, uint8_t *out_rgb)
     {
-      double msh0[3], msh1[3], msh[3], m;
+      double msh0[3] = {}, msh1[3] = {}, msh[3] = {}, m = 0;
 
       conv_rgb_to_msh(in_rgb0, msh0);
       conv_rgb_to_msh(in_rgb1, msh1);
 
-      if ((msh0[1] > 0.05 && msh1[1] > 0.05) && fabs(msh0[2] - msh1[2]) > 1.0472)
+      if ((msh0[1] > 0.05 && msh1[1] > 0.05) && cm_fabs(msh0[2] - msh1[2]) > 1.0472)
       {
         if (msh0[0] > msh1[0])
           m = msh0[0];
@@ -1408,15 +1969,37 @@ namespace image     // shl::gtk::image
       conv_msh_to_rgb(msh, out_rgb);
     }
     // -------------------------------------------------------------------------
+    // interpolate_colors
+    // -------------------------------------------------------------------------
+    // The batched version of interpolate_color() for in_num interpolation
+    // ratios. The Msh endpoints are prepared once in double and the per color
+    // Msh -> Lab -> XYZ -> RGB chain runs in float (4 colors at a time with
+    // SSE2). The results can differ by 1 from interpolate_color() where the
+    // exact value is very close to an integer
+    //
+    static void interpolate_colors(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
+                                   const float *in_interp, size_t in_num, uint8_t *out_rgb)
+    {
+      MshChain chain = {};
+      make_msh_chain(in_rgb0, in_rgb1, &chain);
+
+      size_t i = 0;
+#ifdef SHL_IMAGE_USE_SSE2
+      i = interpolate_colors_sse2(chain, in_interp, in_num, out_rgb);
+#endif
+      for (; i < in_num; i++)
+        interpolate_color_float(chain, in_interp[i], out_rgb + i * 3);
+    }
+    // -------------------------------------------------------------------------
     // adjust_hue
     // -------------------------------------------------------------------------
-    static double adjust_hue(const double *in_msh, double in_munsat)
+    static constexpr double adjust_hue(const double *in_msh, double in_munsat)
     {
       if (in_msh[0] >= in_munsat)
         return in_msh[2];
 
-      double hSpin = in_msh[1] * sqrt(in_munsat * in_munsat - in_msh[0] * in_msh[0]) /
-                     (in_msh[0] * sin(in_msh[1]));
+      double hSpin = in_msh[1] * cm_sqrt(in_munsat * in_munsat - in_msh[0] * in_msh[0]) /
+                     (in_msh[0] * cm_sin(in_msh[1]));
 
       if (in_msh[2] > -1.0472)
         return in_msh[2] + hSpin;
@@ -1425,11 +2008,11 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_rgb_to_msh
     // -------------------------------------------------------------------------
-    static void conv_rgb_to_msh(const uint8_t *in_rgb, double *out_msh)
+    static constexpr void conv_rgb_to_msh(const uint8_t *in_rgb, double *out_msh)
     {
-      double rgbL[3];
-      double xyz[3];
-      double lab[3];
+      double rgbL[3] = {};
+      double xyz[3] = {};
+      double lab[3] = {};
 
       conv_rgb_to_lin_rgb(in_rgb, rgbL);
 #ifdef SHL_IMAGE_COLORMAP_USE_D50
@@ -1444,11 +2027,11 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_msh_to_rgb
     // -------------------------------------------------------------------------
-    static void conv_msh_to_rgb(const double *in_msh, uint8_t *out_rgb)
+    static constexpr void conv_msh_to_rgb(const double *in_msh, uint8_t *out_rgb)
     {
-      double lab[3];
-      double xyz[3];
-      double rgbL[3];
+      double lab[3] = {};
+      double xyz[3] = {};
+      double rgbL[3] = {};
 
       conv_msh_to_Lab(in_msh, lab);
 #ifdef SHL_IMAGE_COLORMAP_USE_D50
@@ -1463,25 +2046,25 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_lab_to_msh
     // -------------------------------------------------------------------------
-    static void conv_lab_to_msh(const double *in_lab, double *out_msh)
+    static constexpr void conv_lab_to_msh(const double *in_lab, double *out_msh)
     {
-      out_msh[0] = sqrt(in_lab[0] * in_lab[0] + in_lab[1] * in_lab[1] + in_lab[2] * in_lab[2]);
-      out_msh[1] = acos(in_lab[0] / out_msh[0]);
-      out_msh[2] = atan2(in_lab[2], in_lab[1]);
+      out_msh[0] = cm_sqrt(in_lab[0] * in_lab[0] + in_lab[1] * in_lab[1] + in_lab[2] * in_lab[2]);
+      out_msh[1] = cm_acos(in_lab[0] / out_msh[0]);
+      out_msh[2] = cm_atan2(in_lab[2], in_lab[1]);
     }
     // -------------------------------------------------------------------------
     // conv_msh_to_Lab
     // -------------------------------------------------------------------------
-    static void conv_msh_to_Lab(const double *in_msh, double *out_lab)
+    static constexpr void conv_msh_to_Lab(const double *in_msh, double *out_lab)
     {
-      out_lab[0] = in_msh[0] * cos(in_msh[1]);
-      out_lab[1] = in_msh[0] * sin(in_msh[1]) * cos(in_msh[2]);
-      out_lab[2] = in_msh[0] * sin(in_msh[1]) * sin(in_msh[2]);
+      out_lab[0] = in_msh[0] * cm_cos(in_msh[1]);
+      out_lab[1] = in_msh[0] * cm_sin(in_msh[1]) * cm_cos(in_msh[2]);
+      out_lab[2] = in_msh[0] * cm_sin(in_msh[1]) * cm_sin(in_msh[2]);
     }
     // -------------------------------------------------------------------------
     // conv_xyz_d50_to_lab
     // -------------------------------------------------------------------------
-    static void conv_xyz_d50_to_lab(const double *in_xyz, double *out_lab)
+    static constexpr void conv_xyz_d50_to_lab(const double *in_xyz, double *out_lab)
     {
       const double *wpXyz = get_d50_whitepoint_in_xyz();
 
@@ -1492,7 +2075,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_lab_to_xyz_d50
     // ------------------------------------------------------------------------
-    static void conv_lab_to_xyz_d50(const double *in_lab, double *out_xyz)
+    static constexpr void conv_lab_to_xyz_d50(const double *in_lab, double *out_xyz)
     {
       const double *wpXyz = get_d50_whitepoint_in_xyz();
 
@@ -1503,7 +2086,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_xyz_d65_to_lab
     // -------------------------------------------------------------------------
-    static void conv_xyz_d65_to_lab(const double *in_xyz, double *out_lab)
+    static constexpr void conv_xyz_d65_to_lab(const double *in_xyz, double *out_lab)
     {
       const double *wpXyz = get_d65_whitepoint_in_xyz();
 
@@ -1514,7 +2097,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_lab_to_xyz_d65
     // -------------------------------------------------------------------------
-    static void conv_lab_to_xyz_d65(const double *in_lab, double *out_xyz)
+    static constexpr void conv_lab_to_xyz_d65(const double *in_lab, double *out_xyz)
     {
       const double *wpXyz = get_d65_whitepoint_in_xyz();
 
@@ -1525,7 +2108,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_lin_rgb_to_xyz (from sRGB linear (D65) to XYZ (D65) color space)
     // -------------------------------------------------------------------------
-    static void conv_lin_rgb_to_xyz(const double *in_rgb_l, double *out_xyz)
+    static constexpr void conv_lin_rgb_to_xyz(const double *in_rgb_l, double *out_xyz)
     {
       out_xyz[0] = 0.412391 * in_rgb_l[0] + 0.357584 * in_rgb_l[1] + 0.180481 * in_rgb_l[2];
       out_xyz[1] = 0.212639 * in_rgb_l[0] + 0.715169 * in_rgb_l[1] + 0.072192 * in_rgb_l[2];
@@ -1534,7 +2117,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_xyz_to_lin_rgb (from XYZ (D65) to sRGB linear (D65) color space)
     // -------------------------------------------------------------------------
-    static void conv_xyz_to_lin_rgb(const double *in_xyz, double *out_rgb_l)
+    static constexpr void conv_xyz_to_lin_rgb(const double *in_xyz, double *out_rgb_l)
     {
       out_rgb_l[0] = 3.240970 * in_xyz[0] - 1.537383 * in_xyz[1] - 0.498611 * in_xyz[2];
       out_rgb_l[1] = -0.969244 * in_xyz[0] + 1.875968 * in_xyz[1] + 0.041555 * in_xyz[2];
@@ -1543,7 +2126,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_lin_rgb_to_xyz_d50 (from sRGB linear (D65) to XYZ (D50) color space)
     // -------------------------------------------------------------------------
-    static void conv_lin_rgb_to_xyz_d50(const double *in_rgb_l, double *out_xyz)
+    static constexpr void conv_lin_rgb_to_xyz_d50(const double *in_rgb_l, double *out_xyz)
     {
       out_xyz[0] = 0.436041 * in_rgb_l[0] + 0.385113 * in_rgb_l[1] + 0.143046 * in_rgb_l[2];
       out_xyz[1] = 0.222485 * in_rgb_l[0] + 0.716905 * in_rgb_l[1] + 0.060610 * in_rgb_l[2];
@@ -1552,7 +2135,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_xyz_d50_to_lin_rgb (from XYZ (D50) to sRGB linear (D65) color space)
     // -------------------------------------------------------------------------
-    static void conv_xyz_d50_to_lin_rgb(const double *in_xyz, double *out_rgb_l)
+    static constexpr void conv_xyz_d50_to_lin_rgb(const double *in_xyz, double *out_rgb_l)
     {
       out_rgb_l[0] = 3.134187 * in_xyz[0] - 1.617209 * in_xyz[1] - 0.490694 * in_xyz[2];
       out_rgb_l[1] = -0.978749 * in_xyz[0] + 1.916130 * in_xyz[1] + 0.033433 * in_xyz[2];
@@ -1561,9 +2144,9 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     // conv_rgb_to_lin_rgb (from sRGB to linear sRGB)
     // -------------------------------------------------------------------------
-    static void conv_rgb_to_lin_rgb(const uint8_t *in_rgb, double *out_rgb_l)
+    static constexpr void conv_rgb_to_lin_rgb(const uint8_t *in_rgb, double *out_rgb_l)
     {
-      double value;
+      double value = 0;
 
       for (int i = 0; i < 3; i++)
       {
@@ -1571,16 +2154,16 @@ namespace image     // shl::gtk::image
         if (value <= 0.040450)
           value = value / 12.92;
         else
-          value = pow((value + 0.055) / 1.055, 2.4);
+          value = cm_pow((value + 0.055) / 1.055, 2.4);
         out_rgb_l[i] = value;
       }
     }
     // -------------------------------------------------------------------------
     // conv_lin_rgb_to_rgb (from linear sRGB to sRGB)
     // -------------------------------------------------------------------------
-    static void conv_lin_rgb_to_rgb(const double *in_rgb_l, uint8_t *out_rgb)
+    static constexpr void conv_lin_rgb_to_rgb(const double *in_rgb_l, uint8_t *out_rgb)
     {
-      double value;
+      double value = 0;
 
       for (int i = 0; i < 3; i++)
       {
@@ -1588,7 +2171,7 @@ namespace image     // shl::gtk::image
         if (value <= 0.0031308)
           value = value * 12.92;
         else
-          value = 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+          value = 1.055 * cm_pow(value, 1.0 / 2.4) - 0.055;
 
         value = value * 255;
         if (value < 0)
@@ -1606,6 +2189,7 @@ namespace image     // shl::gtk::image
       CMType_Linear = 1,
       CMType_Diverging
     };
+    static constexpr ColormapIndex BUILTIN_COLORMAP_LAST = COLORMAP_GreenRed;
     // Typedefs ----------------------------------------------------------------
     typedef struct
     {
@@ -1620,934 +2204,5812 @@ namespace image     // shl::gtk::image
       ColorMapType type;
       ColormapRGB rgb;
     } ColormapData;
+    struct ColormapKey
+    {
+      ColormapIndex index;
+      unsigned int color_num;
+      unsigned int multi_num;
+      double gain;
+      int offset;
+
+      bool operator==(const ColormapKey &in_key) const
+      {
+        return index == in_key.index && color_num == in_key.color_num &&
+               multi_num == in_key.multi_num && gain == in_key.gain &&
+               offset == in_key.offset;
+      }
+    };
+    struct ColormapCacheEntry
+    {
+      ColormapKey key;
+      ColormapLUT lut;
+      uint64_t last_used;
+    };
+    struct ColormapCache
+    {
+      std::mutex mutex;
+      std::vector<ColormapCacheEntry> entries;
+      uint64_t use_count = 0;
+    };
+    struct CustomColormap
+    {
+      std::vector<ColormapData> points;   // Empty for the full LUT
+      ColormapLUT lut;                    // nullptr for the control points
+      unsigned int lut_color_num = 0;
+
+      bool is_same(const CustomColormap &in_colormap) const
+      {
+        if (points.size() != in_colormap.points.size() ||
+            lut_color_num != in_colormap.lut_color_num)
+          return false;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+          const ColormapData &a = points[i];
+          const ColormapData &b = in_colormap.points[i];
+          if (a.ratio != b.ratio || a.type != b.type ||
+              a.rgb.R != b.rgb.R || a.rgb.G != b.rgb.G || a.rgb.B != b.rgb.B)
+            return false;
+        }
+        return lut_color_num == 0 ||
+               std::memcmp(lut.get(), in_colormap.lut.get(), (size_t )lut_color_num * 3) == 0;
+      }
+    };
+    struct CustomColormaps
+    {
+      // entries[i] is registered as COLORMAP_CUSTOM + i (never removed)
+      std::mutex mutex;
+      std::vector<std::shared_ptr<const CustomColormap>> entries;
+    };
+
+    struct MshHalf
+    {
+      // msh = base + interp * slope
+      float base[3];
+      float slope[3];
+    };
+    struct MshChain
+    {
+      // half[0] is used for interp < 0.5 and half[1] for the rest
+      // (they are the same unless the interpolation passes through white)
+      MshHalf half[2];
+      // XYZ -> linear RGB matrix with the white point folded in
+      float lab_to_rgb[9];
+    };
+    struct BuiltinColormaps
+    {
+      uint8_t lut[BUILTIN_COLORMAP_LAST - COLORMAP_GrayScale + 1][BUILTIN_COLOR_NUM * 3];
+    };
+
+    // Constants (Colormap data) -----------------------------------------------
+    static constexpr double D50_WHITE_POINT[3] = {0.9642, 1.0, 0.8249};
+    static constexpr double D65_WHITE_POINT[3] = {0.95047, 1.0, 1.08883};
+    static constexpr double CE_PI = 3.14159265358979323846;
+    static constexpr double CE_2PI = 6.28318530717958647692;
+    static constexpr double CE_SQRT2 = 1.41421356237309504880;
+    static constexpr double CE_LN2 = 0.69314718055994530942;
+    static constexpr double CE_LN2_HI = 6.93147180369123816490e-01;
+    static constexpr double CE_LN2_LO = 1.90821492927058770002e-10;
+    // pi / 2 split into 3 parts for the argument reduction of sincos_float
+    static constexpr float PI_2_HI_F = 1.5703125f;
+    static constexpr float PI_2_MID_F = 4.837512969970703125e-4f;
+    static constexpr float PI_2_LO_F = 7.54978995489188216e-8f;
+    static constexpr float SIN_C0_F = -1.6666654611e-1f;
+    static constexpr float SIN_C1_F = 8.3321608736e-3f;
+    static constexpr float SIN_C2_F = -1.9515295891e-4f;
+    static constexpr float COS_C0_F = 4.166664568298827e-2f;
+    static constexpr float COS_C1_F = -1.388731625493765e-3f;
+    static constexpr float COS_C2_F = 2.443315711809948e-5f;
+    static constexpr ColormapData COLORMAP_DATA[] =
+            {
+                    // GrayScale
+                    {COLORMAP_GrayScale,      0.0,  CMType_Linear,    {0,   0,   0}},
+                    {COLORMAP_GrayScale,      1.0,  CMType_Linear,    {255, 255, 255}},
+                    // Jet
+                    {COLORMAP_Jet,            0.0,  CMType_Linear,    {0,   0,   127}},
+                    {COLORMAP_Jet,            0.1,  CMType_Linear,    {0,   0,   255}},
+                    {COLORMAP_Jet,            0.35, CMType_Linear,    {0,   255, 255}},
+                    {COLORMAP_Jet,            0.5,  CMType_Linear,    {0,   255, 0}},
+                    {COLORMAP_Jet,            0.65, CMType_Linear,    {255, 255, 0}},
+                    {COLORMAP_Jet,            0.9,  CMType_Linear,    {255, 0,   0}},
+                    {COLORMAP_Jet,            1.0,  CMType_Linear,    {127, 0,   0}},
+                    // Rainbow
+                    {COLORMAP_Rainbow,        0.0,  CMType_Linear,    {0,   0,   255}},
+                    {COLORMAP_Rainbow,        0.25, CMType_Linear,    {0,   255, 255}},
+                    {COLORMAP_Rainbow,        0.5,  CMType_Linear,    {0,   255, 0}},
+                    {COLORMAP_Rainbow,        0.75, CMType_Linear,    {255, 255, 0}},
+                    {COLORMAP_Rainbow,        1.0,  CMType_Linear,    {255, 0,   0}},
+                    // Rainbow Wide
+                    {COLORMAP_RainbowWide,    0.0,  CMType_Linear,    {0,   0,   0}},
+                    {COLORMAP_RainbowWide,    0.1,  CMType_Linear,    {0,   0,   255}},
+                    {COLORMAP_RainbowWide,    0.3,  CMType_Linear,    {0,   255, 255}},
+                    {COLORMAP_RainbowWide,    0.5,  CMType_Linear,    {0,   255, 0}},
+                    {COLORMAP_RainbowWide,    0.7,  CMType_Linear,    {255, 255, 0}},
+                    {COLORMAP_RainbowWide,    0.9,  CMType_Linear,    {255, 0,   0}},
+                    {COLORMAP_RainbowWide,    1.0,  CMType_Linear,    {255, 255, 255}},
+                    // Spectrum
+                    {COLORMAP_Spectrum,       0.0,  CMType_Linear,    {255, 0,   255}},
+                    {COLORMAP_Spectrum,       0.1,  CMType_Linear,    {0,   0,   255}},
+                    {COLORMAP_Spectrum,       0.3,  CMType_Linear,    {0,   255, 255}},
+                    {COLORMAP_Spectrum,       0.45, CMType_Linear,    {0,   255, 0}},
+                    {COLORMAP_Spectrum,       0.6,  CMType_Linear,    {255, 255, 0}},
+                    {COLORMAP_Spectrum,       1.0,  CMType_Linear,    {255, 0,   0}},
+                    // Spectrum Wide
+                    {COLORMAP_SpectrumWide,   0.0,  CMType_Linear,    {0,   0,   0}},
+                    {COLORMAP_SpectrumWide,   0.1,  CMType_Linear,    {150, 0,   150}},
+                    {COLORMAP_SpectrumWide,   0.2,  CMType_Linear,    {0,   0,   255}},
+                    {COLORMAP_SpectrumWide,   0.35, CMType_Linear,    {0,   255, 255}},
+                    {COLORMAP_SpectrumWide,   0.5,  CMType_Linear,    {0,   255, 0}},
+                    {COLORMAP_SpectrumWide,   0.6,  CMType_Linear,    {255, 255, 0}},
+                    {COLORMAP_SpectrumWide,   0.9,  CMType_Linear,    {255, 0,   0}},
+                    {COLORMAP_SpectrumWide,   1.0,  CMType_Linear,    {255, 255, 255}},
+                    // Thermal
+                    {COLORMAP_Thermal,        0.0,  CMType_Linear,    {0,   0,   255}},
+                    {COLORMAP_Thermal,        0.5,  CMType_Linear,    {255, 0,   255}},
+                    {COLORMAP_Thermal,        1.0,  CMType_Linear,    {255, 255, 0}},
+                    // Thermal Wide
+                    {COLORMAP_ThermalWide,    0.0,  CMType_Linear,    {0,   0,   0}},
+                    {COLORMAP_ThermalWide,    0.05, CMType_Linear,    {0,   0,   255}},
+                    {COLORMAP_ThermalWide,    0.5,  CMType_Linear,    {255, 0,   255}},
+                    {COLORMAP_ThermalWide,    0.95, CMType_Linear,    {255, 255, 0}},
+                    {COLORMAP_ThermalWide,    1.0,  CMType_Linear,    {255, 255, 255}},
+
+                    // Cool Warm
+                    {COLORMAP_CoolWarm,       0.0,  CMType_Diverging, {59,  76,  192}},
+                    {COLORMAP_CoolWarm,       1.0,  CMType_Diverging, {180, 4,   38}},
+                    // PurpleOrange
+                    {COLORMAP_PurpleOrange,   0.0,  CMType_Diverging, {111, 78,  161}},
+                    {COLORMAP_PurpleOrange,   1.0,  CMType_Diverging, {193, 85,  11}},
+                    // GreenPurple
+                    {COLORMAP_GreenPurple,    0.0,  CMType_Diverging, {21,  135, 51}},
+                    {COLORMAP_GreenPurple,    1.0,  CMType_Diverging, {111, 78,  161}},
+                    // Blue DarkYellow
+                    {COLORMAP_BlueDarkYellow, 0.0,  CMType_Diverging, {55,  133, 232}},
+                    {COLORMAP_BlueDarkYellow, 1.0,  CMType_Diverging, {172, 125, 23}},
+                    // Green Red
+                    {COLORMAP_GreenRed,       0.0,  CMType_Diverging, {21,  135, 51}},
+                    {COLORMAP_GreenRed,       1.0,  CMType_Diverging, {193, 54,  59}},
+
+                    // End mark (Don't remove this)
+                    {COLORMAP_END,            0.0,  CMType_Linear,    {0,   0,   0}}
+            };
 
     // Static Functions --------------------------------------------------------
     // -------------------------------------------------------------------------
+    // get_colormap_cache
+    // -------------------------------------------------------------------------
+    // Never destroyed, so that the LUTs can be requested at any time
+    //
+    static ColormapCache *get_colormap_cache()
+    {
+      static auto *s_cache = new ColormapCache();
+      return s_cache;
+    }
+    // -------------------------------------------------------------------------
+    // get_custom_colormaps
+    // -------------------------------------------------------------------------
+    // Never destroyed as well as the cache
+    //
+    static CustomColormaps *get_custom_colormaps()
+    {
+      static auto *s_custom = new CustomColormaps();
+      return s_custom;
+    }
+    // -------------------------------------------------------------------------
+    // add_custom_colormap
+    // -------------------------------------------------------------------------
+    static ColormapIndex add_custom_colormap(const std::shared_ptr<CustomColormap> &in_colormap)
+    {
+      CustomColormaps *custom = get_custom_colormaps();
+      std::lock_guard<std::mutex> lock(custom->mutex);
+      for (size_t i = 0; i < custom->entries.size(); i++)
+      {
+        if (custom->entries[i]->is_same(*in_colormap))
+          return (ColormapIndex )(COLORMAP_CUSTOM + i);
+      }
+      if (COLORMAP_CUSTOM + custom->entries.size() >= COLORMAP_ANY)
+        return COLORMAP_NOT_SPECIFIED;
+      ColormapIndex index = (ColormapIndex )(COLORMAP_CUSTOM + custom->entries.size());
+      for (auto &point : in_colormap->points)
+        point.index = index;
+      custom->entries.push_back(in_colormap);
+      return index;
+    }
+    // -------------------------------------------------------------------------
+    // find_custom_colormap
+    // -------------------------------------------------------------------------
+    static std::shared_ptr<const CustomColormap> find_custom_colormap(ColormapIndex in_index)
+    {
+      if (in_index < COLORMAP_CUSTOM)
+        return nullptr;
+      CustomColormaps *custom = get_custom_colormaps();
+      std::lock_guard<std::mutex> lock(custom->mutex);
+      size_t pos = (size_t )(in_index - COLORMAP_CUSTOM);
+      if (pos >= custom->entries.size())
+        return nullptr;
+      return custom->entries[pos];
+    }
+    // -------------------------------------------------------------------------
+    // calc_custom_colormap
+    // -------------------------------------------------------------------------
+    static void calc_custom_colormap(ColormapIndex in_index,
+                                     unsigned int in_color_num,
+                                     uint8_t *out_colormap,
+                                     unsigned int in_multi_num,
+                                     double in_gain, int in_offset)
+    {
+      std::shared_ptr<const CustomColormap> custom = find_custom_colormap(in_index);
+      if (!custom)
+      {
+        clear_colormap(in_color_num, out_colormap);
+        return;
+      }
+      if (custom->lut)
+      {
+        resample_colormap(custom->lut.get(), custom->lut_color_num,
+                          in_color_num, out_colormap, in_multi_num, in_gain, in_offset);
+        return;
+      }
+      calc_colormap(custom->points.data(), (unsigned int )custom->points.size(),
+                    in_color_num, out_colormap, in_multi_num, in_gain, in_offset);
+    }
+    // -------------------------------------------------------------------------
+    // resample_colormap
+    // -------------------------------------------------------------------------
+    // Picks the nearest entries of the full LUT. The color i of in_color_num
+    // takes the entry round(i * (in_lut_num - 1) / (in_color_num - 1)), so the
+    // first and the last colors are the ends of the LUT (and in_lut_num ==
+    // in_color_num gives the LUT itself). The gain and the offset scale and
+    // shift i, and each of the in_multi_num repeats covers the whole LUT
+    //
+    static void resample_colormap(const uint8_t *in_lut, unsigned int in_lut_num,
+                                  unsigned int in_color_num, uint8_t *out_colormap,
+                                  unsigned int in_multi_num,
+                                  double in_gain, int in_offset)
+    {
+      if (in_multi_num == 0 || in_gain <= 0.0 || in_color_num == 0)
+      {
+        clear_colormap(in_color_num, out_colormap);
+        return;
+      }
+      double last = (in_color_num > 1) ? (double )(in_color_num - 1) : 1.0;
+      for (unsigned int i = 0; i < in_color_num; i++)
+      {
+        double ratio = ((double )i + in_offset) * in_gain * in_multi_num / last;
+        double repeat = std::floor(ratio);
+        if (repeat < 0)
+          repeat = 0;
+        if (repeat > in_multi_num - 1)
+          repeat = in_multi_num - 1;
+        double pos = (ratio - repeat) * (in_lut_num - 1) + 0.5;
+        unsigned int src = 0;
+        if (pos >= in_lut_num)
+          src = in_lut_num - 1;
+        else if (pos > 0)
+          src = (unsigned int )pos;
+        std::memcpy(&(out_colormap[i * 3]), &(in_lut[src * 3]), 3);
+      }
+    }
+    // -------------------------------------------------------------------------
     // get_d50_whitepoint_in_xyz
     // -------------------------------------------------------------------------
-    static const double *get_d50_whitepoint_in_xyz()
+    static constexpr const double *get_d50_whitepoint_in_xyz()
     {
-      static const double sD50WhitePoint[3] = {0.9642, 1.0, 0.8249};
-      return sD50WhitePoint;
+      return D50_WHITE_POINT;
     }
     // -------------------------------------------------------------------------
     // get_d50_whitepoint_in_xyz
     // -------------------------------------------------------------------------
-    static const double *get_d65_whitepoint_in_xyz()
+    static constexpr const double *get_d65_whitepoint_in_xyz()
     {
-      static const double sD65WhitePoint[3] = {0.95047, 1.0, 1.08883};
-      return sD65WhitePoint;
+      return D65_WHITE_POINT;
     }
     // -------------------------------------------------------------------------
     // lab_sub_func
     // -------------------------------------------------------------------------
-    static double lab_sub_func(double inT)
+    static constexpr double lab_sub_func(double inT)
     {
       if (inT > 0.008856)
-        return pow(inT, (1.0 / 3.0));
+        return cm_pow(inT, (1.0 / 3.0));
       return 7.78703 * inT + 16.0 / 116.0;
     }
     // -------------------------------------------------------------------------
     // lab_sub_inv_func
     // -------------------------------------------------------------------------
-    static double lab_sub_inv_func(double inT)
+    static constexpr double lab_sub_inv_func(double inT)
     {
       if (inT > 0.20689)
-        return pow(inT, 3);
+        return cm_pow(inT, 3);
       return (inT - 16.0 / 116.0) / 7.78703;
     }
     // -------------------------------------------------------------------------
-    // get_multi_colormap_data
+    // cm_pow, cm_sqrt, cm_sin, cm_cos, cm_acos, cm_atan2, cm_fabs
     // -------------------------------------------------------------------------
-    static void get_multi_colormap_data(ColormapIndex in_index,
-                                        unsigned int in_multi_num,
-                                        std::vector<ColormapData> &out_data)
+    // The math functions used by the colormap generation. They call the libm
+    // functions at runtime and the constexpr versions (ce_*) when the built-in
+    // colormaps are generated at compile time
+    //
+    static constexpr double cm_pow(double in_x, double in_y)
     {
-      const ColormapData *colormap_data;
-      unsigned int i, j, data_num;
-      double single_ratio;
-
-      colormap_data = get_colormap_data(in_index);
-      if (colormap_data == nullptr)
-        return;
-
-      data_num = 0;
-      while (colormap_data[data_num].index == in_index)
-        data_num++;
-      single_ratio = 1.0 / (double) in_multi_num;
-
-      out_data.clear();
-      for (i = 0; i < in_multi_num; i++)
-      {
-        for (j = 0; j < data_num; j++)
-        {
-          out_data.push_back(colormap_data[j]);
-          out_data.back().ratio = colormap_data[j].ratio * single_ratio + single_ratio * i;
-        }
-      }
-    }
-    // -------------------------------------------------------------------------
-    // get_colormap_data
-    // -------------------------------------------------------------------------
-    static const ColormapData *get_colormap_data(ColormapIndex in_index)
-    {
-      static const ColormapData s_colormap_data[] =
-              {
-                      // GrayScale
-                      {COLORMAP_GrayScale,      0.0,  CMType_Linear,    {0,   0,   0}},
-                      {COLORMAP_GrayScale,      1.0,  CMType_Linear,    {255, 255, 255}},
-                      // Jet
-                      {COLORMAP_Jet,            0.0,  CMType_Linear,    {0,   0,   127}},
-                      {COLORMAP_Jet,            0.1,  CMType_Linear,    {0,   0,   255}},
-                      {COLORMAP_Jet,            0.35, CMType_Linear,    {0,   255, 255}},
-                      {COLORMAP_Jet,            0.5,  CMType_Linear,    {0,   255, 0}},
-                      {COLORMAP_Jet,            0.65, CMType_Linear,    {255, 255, 0}},
-                      {COLORMAP_Jet,            0.9,  CMType_Linear,    {255, 0,   0}},
-                      {COLORMAP_Jet,            1.0,  CMType_Linear,    {127, 0,   0}},
-                      // Rainbow
-                      {COLORMAP_Rainbow,        0.0,  CMType_Linear,    {0,   0,   255}},
-                      {COLORMAP_Rainbow,        0.25, CMType_Linear,    {0,   255, 255}},
-                      {COLORMAP_Rainbow,        0.5,  CMType_Linear,    {0,   255, 0}},
-                      {COLORMAP_Rainbow,        0.75, CMType_Linear,    {255, 255, 0}},
-                      {COLORMAP_Rainbow,        1.0,  CMType_Linear,    {255, 0,   0}},
-                      // Rainbow Wide
-                      {COLORMAP_RainbowWide,    0.0,  CMType_Linear,    {0,   0,   0}},
-                      {COLORMAP_RainbowWide,    0.1,  CMType_Linear,    {0,   0,   255}},
-                      {COLORMAP_RainbowWide,    0.3,  CMType_Linear,    {0,   255, 255}},
-                      {COLORMAP_RainbowWide,    0.5,  CMType_Linear,    {0,   255, 0}},
-                      {COLORMAP_RainbowWide,    0.7,  CMType_Linear,    {255, 255, 0}},
-                      {COLORMAP_RainbowWide,    0.9,  CMType_Linear,    {255, 0,   0}},
-                      {COLORMAP_RainbowWide,    1.0,  CMType_Linear,    {255, 255, 255}},
-                      // Spectrum
-                      {COLORMAP_Spectrum,       0.0,  CMType_Linear,    {255, 0,   255}},
-                      {COLORMAP_Spectrum,       0.1,  CMType_Linear,    {0,   0,   255}},
-                      {COLORMAP_Spectrum,       0.3,  CMType_Linear,    {0,   255, 255}},
-                      {COLORMAP_Spectrum,       0.45, CMType_Linear,    {0,   255, 0}},
-                      {COLORMAP_Spectrum,       0.6,  CMType_Linear,    {255, 255, 0}},
-                      {COLORMAP_Spectrum,       1.0,  CMType_Linear,    {255, 0,   0}},
-                      // Spectrum Wide
-                      {COLORMAP_SpectrumWide,   0.0,  CMType_Linear,    {0,   0,   0}},
-                      {COLORMAP_SpectrumWide,   0.1,  CMType_Linear,    {150, 0,   150}},
-                      {COLORMAP_SpectrumWide,   0.2,  CMType_Linear,    {0,   0,   255}},
-                      {COLORMAP_SpectrumWide,   0.35, CMType_Linear,    {0,   255, 255}},
-                      {COLORMAP_SpectrumWide,   0.5,  CMType_Linear,    {0,   255, 0}},
-                      {COLORMAP_SpectrumWide,   0.6,  CMType_Linear,    {255, 255, 0}},
-                      {COLORMAP_SpectrumWide,   0.9,  CMType_Linear,    {255, 0,   0}},
-                      {COLORMAP_SpectrumWide,   1.0,  CMType_Linear,    {255, 255, 255}},
-                      // Thermal
-                      {COLORMAP_Thermal,        0.0,  CMType_Linear,    {0,   0,   255}},
-                      {COLORMAP_Thermal,        0.5,  CMType_Linear,    {255, 0,   255}},
-                      {COLORMAP_Thermal,        1.0,  CMType_Linear,    {255, 255, 0}},
-                      // Thermal Wide
-                      {COLORMAP_ThermalWide,    0.0,  CMType_Linear,    {0,   0,   0}},
-                      {COLORMAP_ThermalWide,    0.05, CMType_Linear,    {0,   0,   255}},
-                      {COLORMAP_ThermalWide,    0.5,  CMType_Linear,    {255, 0,   255}},
-                      {COLORMAP_ThermalWide,    0.95, CMType_Linear,    {255, 255, 0}},
-                      {COLORMAP_ThermalWide,    1.0,  CMType_Linear,    {255, 255, 255}},
-
-                      // Cool Warm
-                      {COLORMAP_CoolWarm,       0.0,  CMType_Diverging, {59,  76,  192}},
-                      {COLORMAP_CoolWarm,       1.0,  CMType_Diverging, {180, 4,   38}},
-                      // PurpleOrange
-                      {COLORMAP_PurpleOrange,   0.0,  CMType_Diverging, {111, 78,  161}},
-                      {COLORMAP_PurpleOrange,   1.0,  CMType_Diverging, {193, 85,  11}},
-                      // GreenPurple
-                      {COLORMAP_GreenPurple,    0.0,  CMType_Diverging, {21,  135, 51}},
-                      {COLORMAP_GreenPurple,    1.0,  CMType_Diverging, {111, 78,  161}},
-                      // Blue DarkYellow
-                      {COLORMAP_BlueDarkYellow, 0.0,  CMType_Diverging, {55,  133, 232}},
-                      {COLORMAP_BlueDarkYellow, 1.0,  CMType_Diverging, {172, 125, 23}},
-                      // Green Red
-                      {COLORMAP_GreenRed,       0.0,  CMType_Diverging, {21,  135, 51}},
-                      {COLORMAP_GreenRed,       1.0,  CMType_Diverging, {193, 54,  59}},
-
-                      // End mark (Don't remove this)
-                      {COLORMAP_END,            0.0,  CMType_Linear,    {0,   0,   0}}
-              };
-      const ColormapData *colormap_data = s_colormap_data;
-
-      while (colormap_data->index != in_index)
-      {
-        colormap_data++;
-        if (colormap_data->index == COLORMAP_END)
-          return nullptr;
-      }
-      return colormap_data;
+      if (__builtin_is_constant_evaluated())
+        return ce_pow(in_x, in_y);
+      return pow(in_x, in_y);
     }
-  };
-
-  // ===========================================================================
-  //  PerfCounter class
-  // ===========================================================================
-  class PerfCounter
-  {
-  public:
-    PerfCounter()
+    static constexpr double cm_sqrt(double in_x)
     {
-      m_start_count = 0;
+      if (__builtin_is_constant_evaluated())
+        return ce_sqrt(in_x);
+      return sqrt(in_x);
     }
-    virtual ~PerfCounter() = default;
-    uint64_t  get_count()
+    static constexpr double cm_sin(double in_x)
     {
-      struct timespec tp;
-      if (clock_gettime(CLOCK_REALTIME, &tp) < 0)
-      {
-        SHL_ERROR_OUT("clock_gettime() returned error: %d", errno);
-        return 0;
-      }
-      uint64_t v = (uint64_t )tp.tv_nsec;
-      v += (uint64_t )tp.tv_sec * 1000000000L;
-      return v;
+      if (__builtin_is_constant_evaluated())
+        return ce_sin(in_x);
+      return sin(in_x);
     }
-    void start_count()
+    static constexpr double cm_cos(double in_x)
     {
-      m_start_count = get_count();
+      if (__builtin_is_constant_evaluated())
+        return ce_cos(in_x);
+      return cos(in_x);
     }
-    uint64_t  elapsed_time()
+    static constexpr double cm_acos(double in_x)
     {
-      return get_count() - m_start_count;
+      if (__builtin_is_constant_evaluated())
+        return ce_atan2(ce_sqrt((1.0 - in_x) * (1.0 + in_x)), in_x);
+      return acos(in_x);
     }
-
-  private:
-    uint64_t  m_start_count;
-  };
-
-  // ===========================================================================
-  //  Data class
-  // ===========================================================================
-  class Data
-  {
-  public:
-    // -------------------------------------------------------------------------
-    // Data destructor
-    // -------------------------------------------------------------------------
-    virtual ~Data()
+    static constexpr double cm_atan2(double in_y, double in_x)
     {
-      delete m_allocated_buffer_ptr;
+      if (__builtin_is_constant_evaluated())
+        return ce_atan2(in_y, in_x);
+      return atan2(in_y, in_x);
+    }
+    static constexpr double cm_fabs(double in_x)
+    {
+      return in_x < 0 ? -in_x : in_x;
     }
-
-    // Member functions --------------------------------------------------------
     // -------------------------------------------------------------------------
-    // allocate
+    // ce_sqrt
     // -------------------------------------------------------------------------
-    /**
-     * Allocates the image buffer internally.
-     *
-     * @param in_width      The width of the image buffer
-     * @param in_height     The height of the image
-     * @param in_is_mono    The type of the image
-     *  - true : Allocates the image buffer for the monochrome image (8bit x 1ch = MONO8)
-     *  - false : Allocates the image buffer for the color image (8bit x 3ch = RGB8)
-     * @return  The result of the function call
-     *  - true : The allocation was successful
-     *  - false : The allocation was failed
-     */
-    bool allocate(int in_width, int in_height, bool in_is_mono = false)
+    static constexpr double ce_sqrt(double in_x)
     {
-      if (in_width == 0 || in_height == 0)
+      if (in_x <= 0.0)
+        return 0.0;
+      // Scale into [1, 4) so that a fixed number of Newton steps is enough
+      double scale = 1.0;
+      while (in_x >= 4.0)
       {
-        cleanup_buffers();
-        return false;
+        in_x *= 0.25;
+        scale *= 2.0;
       }
-      //
-      m_external_buffer_ptr = nullptr;
-      m_width = in_width;
-      m_height = in_height;
-      m_is_mono = in_is_mono;
-      update_image_buffer_size();
-      m_allocated_buffer_ptr = new uint8_t[m_buffer_size];
-      if (m_allocated_buffer_ptr == nullptr)
+      while (in_x < 1.0)
       {
-        cleanup_buffers();
-        return false;
+        in_x *= 4.0;
+        scale *= 0.5;
       }
-      ::memset(m_allocated_buffer_ptr, 0, m_buffer_size);
-      return true;
+      double v = (1.0 + in_x) * 0.5;
+      for (int i = 0; i < 6; i++)
+        v = 0.5 * (v + in_x / v);
+      return v * scale;
     }
     // -------------------------------------------------------------------------
-    // set_external_buffer
+    // ce_exp
     // -------------------------------------------------------------------------
-    /**
-     * Specifies the external image buffer.
-     *
-     * @param in_buffer_ptr     The pointer for the external image buffer
-     * @param in_width          The height of the image
-     * @param in_height         The height of the image
-     * @param in_is_mono        The type of the image
-     *  - true : Allocates the image buffer for the monochrome image (8bit x 1ch = MONO8)
-     *  - false : Allocates the image buffer for the color image (8bit x 3ch = RGB8)
-     * @param in_skip_frame_counter_update
-     *  - true : Skips incrementing the frame counter. The frame counter will be unchanged.
-     *  - false : The frame counter will be incremented (updated).
-     * @return  The result of the function call
-     *  - true : Changing the image buffer was successful
-     *  - false : An error has occurred. The parameter specified was wrong.
-     */
-    bool set_external_buffer(uint8_t *in_buffer_ptr, int in_width, int in_height, bool in_is_mono = false,
-                             bool in_skip_frame_counter_update = false)
+    static constexpr double ce_exp(double in_x)
     {
-      if (in_buffer_ptr == nullptr || in_width == 0 || in_height == 0)
+      // exp(x) = 2^k * exp(r), |r| <= ln2 / 2
+      int k = (int) (in_x / CE_LN2 + (in_x < 0 ? -0.5 : 0.5));
+      double r = (in_x - k * CE_LN2_HI) - k * CE_LN2_LO;
+      double term = 1.0, sum = 1.0;
+      for (int n = 1; n < 18; n++)
       {
-        cleanup_buffers();
-        return false;
+        term *= r / n;
+        sum += term;
       }
-      //
-      if (m_allocated_buffer_ptr != nullptr)
+      for (; k > 0; k--)
+        sum *= 2.0;
+      for (; k < 0; k++)
+        sum *= 0.5;
+      return sum;
+    }
+    // -------------------------------------------------------------------------
+    // ce_log
+    // -------------------------------------------------------------------------
+    static constexpr double ce_log(double in_x)
+    {
+      // log(x) = e * ln2 + 2 * atanh((m - 1) / (m + 1)), m in [sqrt(0.5), sqrt(2))
+      int e = 0;
+      while (in_x >= CE_SQRT2)
       {
-        delete m_allocated_buffer_ptr;
-        m_allocated_buffer_ptr = nullptr;
+        in_x *= 0.5;
+        e++;
       }
-      m_external_buffer_ptr = in_buffer_ptr;
-      m_width = in_width;
-      m_height = in_height;
-      m_is_mono = in_is_mono;
-      update_image_buffer_size();
-      mark_as_modified(in_skip_frame_counter_update);
-      return true;
+      while (in_x < CE_SQRT2 * 0.5)
+      {
+        in_x *= 2.0;
+        e--;
+      }
+      double t = (in_x - 1.0) / (in_x + 1.0);
+      double t2 = t * t, term = t, sum = 0.0;
+      for (int n = 1; n < 26; n += 2)
+      {
+        sum += term / n;
+        term *= t2;
+      }
+      return (e * CE_LN2_HI + 2.0 * sum) + e * CE_LN2_LO;
     }
     // -------------------------------------------------------------------------
-    // get_image
+    // ce_pow
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the pointer for the image buffer.
-     * @note The image buffer needs to be allocated beforehand.
-     *
-     * @return The pointer for the image buffer
-     */
-    [[nodiscard]] uint8_t *get_image() const
+    static constexpr double ce_pow(double in_x, double in_y)
     {
-      if (m_allocated_buffer_ptr != nullptr)
-        return m_allocated_buffer_ptr;
-      return m_external_buffer_ptr;
+      if (in_x <= 0.0)
+        return 0.0;
+      if (in_y == 3.0)
+        return in_x * in_x * in_x;
+      return ce_exp(in_y * ce_log(in_x));
     }
     // -------------------------------------------------------------------------
-    // get_pixel_value
+    // ce_sin
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the pixel value of the image buffer.
-     * @note The image buffer needs to be allocated beforehand.
-     *
-     * @param in_x          The x position of the pixel
-     * @param in_y          The y position of the pixel
-     * @param out_is_mono   The type of the image
-     *  - true : Allocates the image buffer for the monochrome image (8bit x 1ch = MONO8)
-     *  - false : Allocates the image buffer for the color image (8bit x 3ch = RGB8)
-     * @param out_r         The pixel value of the specified location (The r component or monochrome pixel value)
-     * @param out_g         The pixel value of the specified location (The g component of the pixel value)
-     * @param out_b         The pixel value of the specified location (The b component of the pixel value)
-     * @return  The result of the function call
-     *  - true : Changing the image buffer was successful
-     *  - false : An error has occurred. The parameter specified was wrong.
-     */
-    virtual bool get_pixel_value(int in_x, int in_y,
-                         bool *out_is_mono, int *out_r, int *out_g, int *out_b)
+    static constexpr double ce_sin(double in_x)
     {
-      if (is_valid() == false)
-        return false;
-      if (in_x < 0 || in_x > get_width() ||
-          in_y < 0 || in_y > get_height())
-        return false;
-      //
-      *out_is_mono = is_mono();
-      unsigned char *pixBuf = get_image();
-      if (*out_is_mono)
+      // Reduce to [-pi/2, pi/2]
+      in_x -= CE_2PI * (int) (in_x / CE_2PI + (in_x < 0 ? -0.5 : 0.5));
+      if (in_x > CE_PI * 0.5)
+        in_x = CE_PI - in_x;
+      else if (in_x < -CE_PI * 0.5)
+        in_x = -CE_PI - in_x;
+      double x2 = in_x * in_x, term = in_x, sum = in_x;
+      for (int n = 1; n < 12; n++)
       {
-        *out_r = pixBuf[in_y * get_width() + in_x];
-        *out_g = 0;
-        *out_b = 0;
+        term *= -x2 / ((2 * n) * (2 * n + 1));
+        sum += term;
       }
-      else
+      return sum;
+    }
+    // -------------------------------------------------------------------------
+    // ce_cos
+    // -------------------------------------------------------------------------
+    static constexpr double ce_cos(double in_x)
+    {
+      // Reduce to [-pi/2, pi/2] (cos(x) = -cos(pi - x))
+      double sign = 1.0;
+      in_x -= CE_2PI * (int) (in_x / CE_2PI + (in_x < 0 ? -0.5 : 0.5));
+      if (in_x > CE_PI * 0.5)
       {
-        size_t index = (in_y * get_width() + in_x) * 3;
-        *out_r = pixBuf[index];
-        *out_g = pixBuf[index+1];
-        *out_b = pixBuf[index+2];
+        in_x = CE_PI - in_x;
+        sign = -1.0;
+      } else if (in_x < -CE_PI * 0.5)
+      {
+        in_x = -CE_PI - in_x;
+        sign = -1.0;
       }
-      return true;
+      double x2 = in_x * in_x, term = 1.0, sum = 1.0;
+      for (int n = 1; n < 12; n++)
+      {
+        term *= -x2 / ((2 * n - 1) * (2 * n));
+        sum += term;
+      }
+      return sign * sum;
     }
     // -------------------------------------------------------------------------
-    // mark_as_modified
+    // ce_atan
     // -------------------------------------------------------------------------
-    /**
-     * Marks the image buffer as modified. Once the modified flag of the image
-     * is set by calling this function and if there is a window displaying
-     * the image buffer, the window will be redrawed to display the updated
-     * image buffer.
-     *
-     * @param in_skip_frame_counter_update
-     *  - true : Will skip incrementing the frame counter
-     *  - false : Will not increment the frame counter
-     */
-    void mark_as_modified(bool in_skip_frame_counter_update = false)
+    static constexpr double ce_atan(double in_x)
     {
-      m_is_image_modified = true;
-      if (in_skip_frame_counter_update == false)
-        increment_frame_counter();
+      if (in_x < 0.0)
+        return -ce_atan(-in_x);
+      if (in_x > 1.0)
+        return CE_PI * 0.5 - ce_atan(1.0 / in_x);
+      // atan(x) = 2 * atan(x / (1 + sqrt(1 + x^2))), applied twice
+      for (int i = 0; i < 2; i++)
+        in_x = in_x / (1.0 + ce_sqrt(1.0 + in_x * in_x));
+      double x2 = in_x * in_x, term = in_x, sum = 0.0;
+      for (int n = 1; n < 26; n += 2)
+      {
+        sum += term / n;
+        term *= -x2;
+      }
+      return 4.0 * sum;
     }
     // -------------------------------------------------------------------------
-    // is_modified
+    // ce_atan2
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the modified flag of the image buffer
-     *
-     * @return  The state of the modified flag
-     *  - true : The image buffer is marked as modified
-     *  - false : The image buffer is not marked as modified
-     */
-    [[nodiscard]] bool is_modified() const
+    static constexpr double ce_atan2(double in_y, double in_x)
     {
-      return m_is_image_modified;
+      if (in_x > 0.0)
+        return ce_atan(in_y / in_x);
+      if (in_x < 0.0)
+        return in_y < 0.0 ? ce_atan(in_y / in_x) - CE_PI : ce_atan(in_y / in_x) + CE_PI;
+      if (in_y > 0.0)
+        return CE_PI * 0.5;
+      if (in_y < 0.0)
+        return -CE_PI * 0.5;
+      return 0.0;
     }
     // -------------------------------------------------------------------------
-    // clear_modified_flag
+    // make_msh_chain
     // -------------------------------------------------------------------------
-    /**
-     * Clears the modified flag of the image buffer.
-     */
-    void clear_modified_flag()
+    // Prepares the per call constants of interpolate_colors() with the same
+    // steps as interpolate_color()
+    //
+    static void make_msh_chain(const uint8_t *in_rgb0, const uint8_t *in_rgb1,
+                               MshChain *out_chain)
+    {
+      double msh0[3] = {}, msh1[3] = {};
+
+      conv_rgb_to_msh(in_rgb0, msh0);
+      conv_rgb_to_msh(in_rgb1, msh1);
+
+      if ((msh0[1] > 0.05 && msh1[1] > 0.05) && fabs(msh0[2] - msh1[2]) > 1.0472)
+      {
+        double m = msh0[0] > msh1[0] ? msh0[0] : msh1[0];
+        if (m < 88)
+          m = 88;
+        const double white[3] = {m, 0, 0};
+        set_msh_half(msh0, white, 2.0, 0.0, &(out_chain->half[0]));   // t = 2 * interp
+        set_msh_half(white, msh1, 2.0, -1.0, &(out_chain->half[1]));  // t = 2 * interp - 1
+      } else
+      {
+        set_msh_half(msh0, msh1, 1.0, 0.0, &(out_chain->half[0]));
+        out_chain->half[1] = out_chain->half[0];
+      }
+
+      // The columns of the matrix are the images of the unit vectors
+      for (int i = 0; i < 3; i++)
+      {
+        double xyz[3] = {0, 0, 0};
+        double rgb_l[3] = {};
+#ifdef SHL_IMAGE_COLORMAP_USE_D50
+        xyz[i] = get_d50_whitepoint_in_xyz()[i];
+        conv_xyz_d50_to_lin_rgb(xyz, rgb_l);
+#else
+        xyz[i] = get_d65_whitepoint_in_xyz()[i];
+        conv_xyz_to_lin_rgb(xyz, rgb_l);
+#endif
+        for (int j = 0; j < 3; j++)
+          out_chain->lab_to_rgb[j * 3 + i] = (float) rgb_l[j];
+      }
+    }
+    // -------------------------------------------------------------------------
+    // set_msh_half
+    // -------------------------------------------------------------------------
+    static void set_msh_half(const double *in_msh0, const double *in_msh1,
+                             double in_scale, double in_bias, MshHalf *out_half)
     {
-      m_is_image_modified = false;
+      double msh0[3] = {in_msh0[0], in_msh0[1], in_msh0[2]};
+      double msh1[3] = {in_msh1[0], in_msh1[1], in_msh1[2]};
+
+      if (msh0[1] < 0.05 && msh1[1] > 0.05)
+        msh0[2] = adjust_hue(msh1, msh0[0]);
+      else if (msh0[1] > 0.05 && msh1[1] < 0.05)
+        msh1[2] = adjust_hue(msh0, msh1[0]);
+
+      // msh = msh0 + t * (msh1 - msh0), t = in_scale * interp + in_bias
+      for (int i = 0; i < 3; i++)
+      {
+        out_half->base[i] = (float) (msh0[i] + in_bias * (msh1[i] - msh0[i]));
+        out_half->slope[i] = (float) (in_scale * (msh1[i] - msh0[i]));
+      }
     }
     // -------------------------------------------------------------------------
-    // set_frame_counter
+    // interpolate_color_float
     // -------------------------------------------------------------------------
-    /**
-     * Sets the frame counter of the image buffer.
-     *
-     * @param in_frame_counter  The new frame counter value
-     */
-    void set_frame_counter(unsigned int in_frame_counter)
+    // The scalar version of interpolate_colors_sse2 (the same operations)
+    //
+    static void interpolate_color_float(const MshChain &in_chain, float in_interp,
+                                        uint8_t *out_rgb)
     {
-      m_frame_counter_initialized = true;
-      m_frame_counter = in_frame_counter;
+      const MshHalf &half = in_chain.half[in_interp < 0.5f ? 0 : 1];
+      float m = half.base[0] + in_interp * half.slope[0];
+      float s = half.base[1] + in_interp * half.slope[1];
+      float h = half.base[2] + in_interp * half.slope[2];
+      float sin_s = 0, cos_s = 0, sin_h = 0, cos_h = 0;
+      sincos_float(s, &sin_s, &cos_s);
+      sincos_float(h, &sin_h, &cos_h);
+
+      float ms = m * sin_s;
+      float fy = (m * cos_s + 16.0f) * (1.0f / 116.0f);
+      float f[3] = {lab_sub_inv_float(fy + ms * cos_h * (1.0f / 500.0f)),
+                    lab_sub_inv_float(fy),
+                    lab_sub_inv_float(fy - ms * sin_h * (1.0f / 200.0f))};
+      const float *mat = in_chain.lab_to_rgb;
+      for (int i = 0; i < 3; i++, mat += 3)
+        out_rgb[i] = lin_rgb_to_rgb_float(mat[0] * f[0] + mat[1] * f[1] + mat[2] * f[2]);
     }
     // -------------------------------------------------------------------------
-    // get_frame_counter
+    // lab_sub_inv_float
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the frame counter of the image buffer.
-     *
-     * @return  The frame counter value of the image buffer
-     */
-    [[nodiscard]] unsigned int get_frame_counter() const
+    static float lab_sub_inv_float(float in_t)
     {
-      if (m_frame_counter_initialized == false)
-        return 0;
-      return m_frame_counter;
+      if (in_t > 0.20689f)
+        return in_t * in_t * in_t;
+      return (in_t - 16.0f / 116.0f) * (1.0f / 7.78703f);
     }
     // -------------------------------------------------------------------------
-    // increment_frame_counter
+    // lin_rgb_to_rgb_float
     // -------------------------------------------------------------------------
-    /**
-     * Increments the frame counter of the image buffer.
-     */
-    void increment_frame_counter()
+    static uint8_t lin_rgb_to_rgb_float(float in_v)
     {
-      if (m_frame_counter_initialized == false)
+      if (in_v <= 0.0031308f)
+        in_v = in_v * 12.92f;
+      else
+        in_v = 1.055f * exp2_float(log2_float(in_v) * (1.0f / 2.4f)) - 0.055f;
+      in_v = in_v * 255.0f;
+      if (in_v < 0.0f)
+        in_v = 0.0f;
+      if (in_v > 255.0f)
+        in_v = 255.0f;
+      return (uint8_t) in_v;
+    }
+    // -------------------------------------------------------------------------
+    // sincos_float
+    // -------------------------------------------------------------------------
+    // Minimax polynomials on [-pi/4, pi/4] after the quadrant reduction
+    // (about 1e-7 of the absolute error for the Msh angles)
+    //
+    static void sincos_float(float in_x, float *out_sin, float *out_cos)
+    {
+      int quadrant = (int) std::lrint(in_x * (float) (2.0 / CE_PI));
+      float q = (float) quadrant;
+      float r = ((in_x - q * PI_2_HI_F) - q * PI_2_MID_F) - q * PI_2_LO_F;
+      float r2 = r * r;
+      float s = r + r * r2 * (SIN_C0_F + r2 * (SIN_C1_F + r2 * SIN_C2_F));
+      float c = 1.0f - 0.5f * r2 + r2 * r2 * (COS_C0_F + r2 * (COS_C1_F + r2 * COS_C2_F));
+      switch (quadrant & 3)
       {
-        m_frame_counter_initialized = true;
-        m_frame_counter = 0;
-        return;
+        case 0: *out_sin = s;  *out_cos = c;  break;
+        case 1: *out_sin = c;  *out_cos = -s; break;
+        case 2: *out_sin = -s; *out_cos = -c; break;
+        default: *out_sin = -c; *out_cos = s; break;
       }
-      m_frame_counter++;
     }
     // -------------------------------------------------------------------------
-    // reset_frame_counter
+    // log2_float (in_x has to be a positive normal number)
     // -------------------------------------------------------------------------
-    /**
-     * Resets the frame counter to zero.
-     */
-    void reset_frame_counter()
+    static float log2_float(float in_x)
     {
-      m_frame_counter_initialized = false;
-      m_frame_counter = 0;
+      int32_t bits = 0;
+      std::memcpy(&bits, &in_x, sizeof(bits));
+      int32_t e = ((bits >> 23) & 0xFF) - 127;
+      bits = (bits & 0x007FFFFF) | 0x3F800000;
+      float m = 0;
+      std::memcpy(&m, &bits, sizeof(m));
+      if (m > (float) CE_SQRT2)
+      {
+        m = m * 0.5f;
+        e++;
+      }
+      // log(m) = 2 * atanh(t), t = (m - 1) / (m + 1)
+      float t = (m - 1.0f) / (m + 1.0f);
+      float t2 = t * t;
+      float ln = t * (2.0f + t2 * (2.0f / 3.0f + t2 * (2.0f / 5.0f +
+                                                      t2 * (2.0f / 7.0f + t2 * (2.0f / 9.0f)))));
+      return ln * (float) (1.0 / CE_LN2) + (float) e;
     }
     // -------------------------------------------------------------------------
-    // get_colormap_index
+    // exp2_float
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the colormap index of the image buffer. The colormap index
-     * is used only when the type of the image buffer is monochrome.
-     *
-     * @return  The colormap index of the image buffer
-     */
-    [[nodiscard]] Colormap::ColormapIndex get_colormap_index() const
+    static float exp2_float(float in_x)
     {
-      return m_colormap_index;
+      int32_t n = (int32_t) std::lrint(in_x);
+      float r = (in_x - (float) n) * (float) CE_LN2;
+      float p = 1.0f + r * (1.0f + r * (1.0f / 2.0f + r * (1.0f / 6.0f + r * (1.0f / 24.0f +
+                                        r * (1.0f / 120.0f + r * (1.0f / 720.0f))))));
+      int32_t bits = 0;
+      std::memcpy(&bits, &p, sizeof(bits));
+      bits += n * (1 << 23);
+      std::memcpy(&p, &bits, sizeof(p));
+      return p;
     }
+#ifdef SHL_IMAGE_USE_SSE2
     // -------------------------------------------------------------------------
-    // set_colormap_index
+    // interpolate_colors_sse2
     // -------------------------------------------------------------------------
-    /**
-     * Set the colormap index of the image buffer. The colormap index
-     * is used only when the type of the image buffer is monochrome.
-     * @note The modified flag of the image buffer will bet set
-     * by calling this function.
-     *
-     * @param in_index  The new colormap index of the image buffer
-     * @param in_skip_frame_counter_update
-     *  - true : Will skip incrementing the frame counter
-     *  - false : Will not increment the frame counter
-     */
-    void set_colormap_index(Colormap::ColormapIndex in_index,
-                            bool in_skip_frame_counter_update = true)
-    {
-      if (m_colormap_index == in_index)
-        return;
-      m_colormap_index = in_index;
-      mark_as_modified(in_skip_frame_counter_update);
+    // 4 colors per iteration. Returns the number of the colors done
+    //
+    static size_t interpolate_colors_sse2(const MshChain &in_chain, const float *in_interp,
+                                          size_t in_num, uint8_t *out_rgb)
+    {
+      const MshHalf &half0 = in_chain.half[0];
+      const MshHalf &half1 = in_chain.half[1];
+      const float *mat = in_chain.lab_to_rgb;
+      size_t i = 0;
+      for (; i + 4 <= in_num; i += 4)
+      {
+        __m128 interp = _mm_loadu_ps(in_interp + i);
+        __m128 lower = _mm_cmplt_ps(interp, _mm_set1_ps(0.5f));
+        __m128 msh[3];
+        for (int j = 0; j < 3; j++)
+        {
+          __m128 base = select_sse2(lower, _mm_set1_ps(half0.base[j]), _mm_set1_ps(half1.base[j]));
+          __m128 slope = select_sse2(lower, _mm_set1_ps(half0.slope[j]), _mm_set1_ps(half1.slope[j]));
+          msh[j] = _mm_add_ps(base, _mm_mul_ps(interp, slope));
+        }
+        __m128 sin_s, cos_s, sin_h, cos_h;
+        sincos_sse2(msh[1], &sin_s, &cos_s);
+        sincos_sse2(msh[2], &sin_h, &cos_h);
+
+        __m128 ms = _mm_mul_ps(msh[0], sin_s);
+        __m128 fy = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(msh[0], cos_s), _mm_set1_ps(16.0f)),
+                               _mm_set1_ps(1.0f / 116.0f));
+        __m128 f[3];
+        f[0] = lab_sub_inv_sse2(_mm_add_ps(fy, _mm_mul_ps(_mm_mul_ps(ms, cos_h),
+                                                          _mm_set1_ps(1.0f / 500.0f))));
+        f[1] = lab_sub_inv_sse2(fy);
+        f[2] = lab_sub_inv_sse2(_mm_sub_ps(fy, _mm_mul_ps(_mm_mul_ps(ms, sin_h),
+                                                          _mm_set1_ps(1.0f / 200.0f))));
+        alignas(16) int32_t rgb[3][4];
+        for (int j = 0; j < 3; j++)
+        {
+          __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(mat[j * 3]), f[0]),
+                                           _mm_mul_ps(_mm_set1_ps(mat[j * 3 + 1]), f[1])),
+                                _mm_mul_ps(_mm_set1_ps(mat[j * 3 + 2]), f[2]));
+          _mm_store_si128((__m128i *) rgb[j], lin_rgb_to_rgb_sse2(v));
+        }
+        for (int j = 0; j < 4; j++, out_rgb += 3)
+        {
+          out_rgb[0] = (uint8_t) rgb[0][j];
+          out_rgb[1] = (uint8_t) rgb[1][j];
+          out_rgb[2] = (uint8_t) rgb[2][j];
+        }
+      }
+      return i;
     }
     // -------------------------------------------------------------------------
-    // get_width
+    // select_sse2 (in_mask ? in_a : in_b)
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the width of the image buffer.
-     *
-     * @return The width of the image buffer
-     */
-    [[nodiscard]] int get_width() const
+    static __m128 select_sse2(__m128 in_mask, __m128 in_a, __m128 in_b)
     {
-      return m_width;
+      return _mm_or_ps(_mm_and_ps(in_mask, in_a), _mm_andnot_ps(in_mask, in_b));
     }
     // -------------------------------------------------------------------------
-    // get_height
+    // lab_sub_inv_sse2
     // -------------------------------------------------------------------------
-    /**
-     * Retries the height of the image buffer.
-     *
-     * @return The height of the image buffer
-     */
-    [[nodiscard]] int get_height() const
+    static __m128 lab_sub_inv_sse2(__m128 in_t)
     {
-      return m_height;
+      __m128 cube = _mm_mul_ps(_mm_mul_ps(in_t, in_t), in_t);
+      __m128 linear = _mm_mul_ps(_mm_sub_ps(in_t, _mm_set1_ps(16.0f / 116.0f)),
+                                 _mm_set1_ps(1.0f / 7.78703f));
+      return select_sse2(_mm_cmpgt_ps(in_t, _mm_set1_ps(0.20689f)), cube, linear);
     }
     // -------------------------------------------------------------------------
-    // is_mono
+    // lin_rgb_to_rgb_sse2
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the type of the image buffer (Mono or Color).
-     *
-     * @return The image buffer type
-     *  - true : The image buffer type is monochrome (MONO8)
-     *  - false : The image buffer type is color (RGB8)
-     */
-    [[nodiscard]] bool is_mono() const
+    static __m128i lin_rgb_to_rgb_sse2(__m128 in_v)
     {
-      return m_is_mono;
+      const __m128 threshold = _mm_set1_ps(0.0031308f);
+      // The pow() side is calculated with the clamped value (log2 needs x > 0)
+      __m128 p = exp2_sse2(_mm_mul_ps(log2_sse2(_mm_max_ps(in_v, threshold)),
+                                      _mm_set1_ps(1.0f / 2.4f)));
+      p = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(1.055f), p), _mm_set1_ps(0.055f));
+      __m128 v = select_sse2(_mm_cmple_ps(in_v, threshold),
+                             _mm_mul_ps(in_v, _mm_set1_ps(12.92f)), p);
+      v = _mm_mul_ps(v, _mm_set1_ps(255.0f));
+      v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255.0f));
+      return _mm_cvttps_epi32(v);
     }
     // -------------------------------------------------------------------------
-    // get_buffer_size
+    // sincos_sse2
     // -------------------------------------------------------------------------
-    /**
-     * Retrieves the size of the image buffer on the memory.
-     *
-     * @return The size of the image (bytes)
-     */
-    [[nodiscard]] size_t get_buffer_size() const
+    static void sincos_sse2(__m128 in_x, __m128 *out_sin, __m128 *out_cos)
     {
-      return m_buffer_size;
+      __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(in_x, _mm_set1_ps((float) (2.0 / CE_PI))));
+      __m128 q = _mm_cvtepi32_ps(quadrant);
+      __m128 r = _mm_sub_ps(in_x, _mm_mul_ps(q, _mm_set1_ps(PI_2_HI_F)));
+      r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(PI_2_MID_F)));
+      r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(PI_2_LO_F)));
+      __m128 r2 = _mm_mul_ps(r, r);
+      __m128 s = _mm_add_ps(_mm_set1_ps(SIN_C1_F), _mm_mul_ps(r2, _mm_set1_ps(SIN_C2_F)));
+      s = _mm_add_ps(_mm_set1_ps(SIN_C0_F), _mm_mul_ps(r2, s));
+      s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+      __m128 c = _mm_add_ps(_mm_set1_ps(COS_C1_F), _mm_mul_ps(r2, _mm_set1_ps(COS_C2_F)));
+      c = _mm_add_ps(_mm_set1_ps(COS_C0_F), _mm_mul_ps(r2, c));
+      c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)),
+                     _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+      // Quadrant 1 and 3 swap sin and cos, the sign follows the quadrant
+      __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)),
+                                                     _mm_set1_epi32(1)));
+      __m128 sin_v = select_sse2(swap, c, s);
+      __m128 cos_v = select_sse2(swap, s, c);
+      __m128 sign_bit = _mm_castsi128_ps(_mm_set1_epi32((int) 0x80000000));
+      __m128 sin_neg = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+      __m128 cos_neg = _mm_castsi128_ps(_mm_slli_epi32(
+              _mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+      *out_sin = _mm_xor_ps(sin_v, _mm_and_ps(sin_neg, sign_bit));
+      *out_cos = _mm_xor_ps(cos_v, _mm_and_ps(cos_neg, sign_bit));
     }
     // -------------------------------------------------------------------------
-    // is_valid
+    // log2_sse2
     // -------------------------------------------------------------------------
-    /**
-     * Checks whether the object holds a valid image buffer or not.
-     * @note To become the valid state, allocate() or set_external_buffer()
-     * needs to be called and returns with the success
-     *
-     * @return
-     *  - true : The image buffer is valid.
-     *  - false : The image buffer is invalid.
-     */
-    [[nodiscard]] bool is_valid() const
+    static __m128 log2_sse2(__m128 in_x)
     {
-      if (m_allocated_buffer_ptr == nullptr && m_external_buffer_ptr == nullptr)
-        return false;
-      if (m_width == 0 || m_height == 0 || m_buffer_size == 0)
-        return false;
-      return true;
+      __m128i bits = _mm_castps_si128(in_x);
+      __m128i e = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xFF)),
+                                _mm_set1_epi32(127));
+      __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                               _mm_set1_epi32(0x3F800000)));
+      __m128 over = _mm_cmpgt_ps(m, _mm_set1_ps((float) CE_SQRT2));
+      m = select_sse2(over, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+      e = _mm_sub_epi32(e, _mm_castps_si128(over));   // -1 (true) -> e + 1
+      __m128 t = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1.0f)), _mm_add_ps(m, _mm_set1_ps(1.0f)));
+      __m128 t2 = _mm_mul_ps(t, t);
+      __m128 p = _mm_add_ps(_mm_set1_ps(2.0f / 7.0f), _mm_mul_ps(t2, _mm_set1_ps(2.0f / 9.0f)));
+      p = _mm_add_ps(_mm_set1_ps(2.0f / 5.0f), _mm_mul_ps(t2, p));
+      p = _mm_add_ps(_mm_set1_ps(2.0f / 3.0f), _mm_mul_ps(t2, p));
+      p = _mm_add_ps(_mm_set1_ps(2.0f), _mm_mul_ps(t2, p));
+      p = _mm_mul_ps(t, p);
+      return _mm_add_ps(_mm_mul_ps(p, _mm_set1_ps((float) (1.0 / CE_LN2))), _mm_cvtepi32_ps(e));
     }
-
-  protected:
     // -------------------------------------------------------------------------
-    // Data constructor
+    // exp2_sse2
     // -------------------------------------------------------------------------
-    Data()
+    static __m128 exp2_sse2(__m128 in_x)
     {
-      m_allocated_buffer_ptr = nullptr;
-      m_external_buffer_ptr = nullptr;
-      m_buffer_size = 0;
-      m_width = 0;
-      m_height = 0;
-      m_is_mono = false;
-      m_is_image_modified = false;
-      m_colormap_index = Colormap::COLORMAP_GrayScale;
-      reset_frame_counter();
+      __m128i n = _mm_cvtps_epi32(in_x);
+      __m128 r = _mm_mul_ps(_mm_sub_ps(in_x, _mm_cvtepi32_ps(n)), _mm_set1_ps((float) CE_LN2));
+      __m128 p = _mm_add_ps(_mm_set1_ps(1.0f / 120.0f), _mm_mul_ps(r, _mm_set1_ps(1.0f / 720.0f)));
+      p = _mm_add_ps(_mm_set1_ps(1.0f / 24.0f), _mm_mul_ps(r, p));
+      p = _mm_add_ps(_mm_set1_ps(1.0f / 6.0f), _mm_mul_ps(r, p));
+      p = _mm_add_ps(_mm_set1_ps(1.0f / 2.0f), _mm_mul_ps(r, p));
+      p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r, p));
+      p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r, p));
+      return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(n, 23)));
     }
-
-    // Member functions --------------------------------------------------------
+#endif
     // -------------------------------------------------------------------------
-    // cleanup_buffers
+    // make_builtin_colormaps
     // -------------------------------------------------------------------------
-    void cleanup_buffers()
+    static constexpr BuiltinColormaps make_builtin_colormaps()
     {
-      if (m_allocated_buffer_ptr != nullptr)
+      BuiltinColormaps colormaps = {};
+      // The control points are passed directly. Going through the index
+      // based calc_colormap() costs GCC several times the constexpr operations
+      for (int i = COLORMAP_GrayScale; i <= BUILTIN_COLORMAP_LAST; i++)
       {
-        delete m_allocated_buffer_ptr;
-        m_allocated_buffer_ptr = nullptr;
+        int data_pos = find_colormap_data((ColormapIndex) i);
+        calc_colormap(&COLORMAP_DATA[data_pos], get_colormap_data_num(data_pos),
+                      BUILTIN_COLOR_NUM, colormaps.lut[i - COLORMAP_GrayScale]);
       }
-      m_external_buffer_ptr = nullptr;
-      m_buffer_size = 0;
-      m_width = 0;
-      m_height = 0;
-      m_is_mono = false;
-      m_is_image_modified = false;
+      return colormaps;
     }
     // -------------------------------------------------------------------------
-    // update_image_buffer_size
+    // calc_colormap
     // -------------------------------------------------------------------------
-    void update_image_buffer_size()
-    {
-      m_buffer_size = m_width * m_height;
-      if (m_is_mono == false)
-        m_buffer_size *= 3;
-      //
-    }
+    // Generates the LUT from in_single_num control points
+    //
+    static constexpr void calc_colormap(const ColormapData *colormap_data,
+                                        unsigned int in_single_num,
+                                        unsigned int in_color_num,
+                                        uint8_t *out_colormap,
+                                        unsigned int in_multi_num = 1,
+                                        double in_gain = 1.0, int in_offset = 0)
+    {
+      unsigned int i = 0, index = 0, num = 0, total = 0, offset = 0, num_all = 0;
+      double ratio0 = 0, ratio1 = 0, offset_ratio = 0;
+
+      // The control points are repeated in_multi_num times
+      unsigned int single_num = in_single_num;
+      unsigned int data_num = single_num * in_multi_num;
+      if (data_num < 2 || in_gain <= 0.0 || in_color_num == 0)
+      {
+        clear_colormap(in_color_num, out_colormap);
+        return;
+      }
 
-  private:
-    // member variables --------------------------------------------------------
-    uint8_t *m_allocated_buffer_ptr;
-    uint8_t *m_external_buffer_ptr;
-    size_t m_buffer_size;
-    int m_width;
-    int m_height;
-    bool m_is_mono;
-    Colormap::ColormapIndex m_colormap_index;
-    bool m_frame_counter_initialized;
-    unsigned int m_frame_counter;
+      offset_ratio = (double) in_offset / (double) in_color_num;
+      ratio0 = get_multi_colormap_ratio(colormap_data, single_num, in_multi_num, index)
+                 / in_gain - offset_ratio;
+      if (ratio0 > 0)
+      {
+        num = (int) ((double) in_color_num * ratio0);
+        if (num > in_color_num)
+          num = in_color_num;
+        for (i = 0; i < num; i++)
+        {
+          out_colormap[0] = colormap_data[index].rgb.R;
+          out_colormap[1] = colormap_data[index].rgb.G;
+          out_colormap[2] = colormap_data[index].rgb.B;
+          out_colormap += 3;
+          total++;
+        }
+      }
 
-    bool m_is_image_modified;
+      uint8_t rgb0[3] = {};
+      uint8_t rgb1[3] = {};
+      while (index + 1 < data_num)
+      {
+        const ColormapData &data0 = colormap_data[index % single_num];
+        const ColormapData &data1 = colormap_data[(index + 1) % single_num];
+        ratio1 = get_multi_colormap_ratio(colormap_data, single_num, in_multi_num, index + 1)
+                   / in_gain - offset_ratio;
+        rgb0[0] = data0.rgb.R;
+        rgb0[1] = data0.rgb.G;
+        rgb0[2] = data0.rgb.B;
+        rgb1[0] = data1.rgb.R;
+        rgb1[1] = data1.rgb.G;
+        rgb1[2] = data1.rgb.B;
+        if (ratio1 > 0)
+        {
+          if (ratio1 == 1.0)  // <- this is to absorb calculation error
+            num_all = in_color_num - total;
+          else
+            num_all = (int) (ratio1 * in_color_num) -
+                      (int) (ratio0 * in_color_num);  // Do not use (ratio1 - ratio0) * in_color_num
+          if (ratio0 < 0.0)
+          {
+            if (ratio1 < 1.0)
+              num = (unsigned int) ((double) in_color_num * ratio1);
+            else
+              num = in_color_num;
+            offset = (int) ((0.0 - ratio0) * (double) in_color_num);
+          } else
+          {
+            num = num_all;
+            offset = 0;
+          }
+          if (num > in_color_num - total)
+            num = in_color_num - total;
+          switch (data0.type)
+          {
+            case CMType_Linear:
+              calc_linear_colormap(rgb0, rgb1, offset, num_all,
+                                   num, out_colormap);
+              break;
+            case CMType_Diverging:
+              calc_diverging_colormap(rgb0, rgb1, offset, num_all,
+                                      num, out_colormap);
+              break;
+          }
+        }
+        ratio0 = ratio1;
+        out_colormap += num * 3;
+        total += num;
+        index++;
+        if (total == in_color_num)
+          break;
+      }
 
-    // friend classes ----------------------------------------------------------
-    friend class View;
+      if (total < in_color_num)
+      {
+        num = in_color_num - total;
+        for (i = 0; i < num; i++)
+        {
+          out_colormap[0] = rgb1[0];
+          out_colormap[1] = rgb1[1];
+          out_colormap[2] = rgb1[2];
+          out_colormap += 3;
+        }
+      }
+    }
+    // -------------------------------------------------------------------------
+    // find_colormap_data
+    // -------------------------------------------------------------------------
+    // Returns the position of the first control point of in_index in
+    // COLORMAP_DATA (-1 if not found). A position is used instead of a pointer,
+    // since comparing a pointer with nullptr is not a constant expression
+    // under -fsanitize=undefined
+    //
+    static constexpr int find_colormap_data(ColormapIndex in_index)
+    {
+      for (int i = 0; COLORMAP_DATA[i].index != COLORMAP_END; i++)
+      {
+        if (COLORMAP_DATA[i].index == in_index)
+          return i;
+      }
+      return -1;
+    }
+    // -------------------------------------------------------------------------
+    // get_colormap_data_num
+    // -------------------------------------------------------------------------
+    static constexpr unsigned int get_colormap_data_num(int in_data_pos)
+    {
+      unsigned int data_num = 0;
+      while (COLORMAP_DATA[in_data_pos + data_num].index == COLORMAP_DATA[in_data_pos].index)
+        data_num++;
+      return data_num;
+    }
+    // -------------------------------------------------------------------------
+    // get_multi_colormap_ratio
+    // -------------------------------------------------------------------------
+    // Returns the ratio of the in_index-th control point when the colormap
+    // (in_single_num control points) is repeated in_multi_num times
+    //
+    static constexpr double get_multi_colormap_ratio(const ColormapData *in_data,
+                                                     unsigned int in_single_num,
+                                                     unsigned int in_multi_num,
+                                                     unsigned int in_index)
+    {
+      double single_ratio = 1.0 / (double) in_multi_num;
+      return in_data[in_index % in_single_num].ratio * single_ratio +
+             single_ratio * (in_index / in_single_num);
+    }
+    // -------------------------------------------------------------------------
+    // get_builtin_colormaps
+    // -------------------------------------------------------------------------
+    // This has to be placed after all the functions used by
+    // make_builtin_colormaps() (they need to be defined when it is evaluated).
+    // With SHL_IMAGE_COLORMAP_RUNTIME_TABLES the tables are generated on the
+    // first call instead (the same values, by the libm versions of cm_*)
+    //
+    static const BuiltinColormaps &get_builtin_colormaps()
+    {
+#ifdef SHL_IMAGE_COLORMAP_RUNTIME_TABLES
+      static const BuiltinColormaps s_builtin = make_builtin_colormaps();
+#else
+      static constexpr BuiltinColormaps s_builtin = make_builtin_colormaps();
+#endif
+      return s_builtin;
+    }
   };
 
   // ===========================================================================
-  //  UpdateHandlerInterface class
+  //  PerfCounter class
   // ===========================================================================
-  class UpdateHandlerInterface
+  class PerfCounter
   {
   public:
-    virtual void view_zoom_updated(double in_zoom, bool in_best_fit) = 0;
-    virtual void view_image_info_updated(bool in_is_valid_image_info,
-                                int in_image_width, int in_image_height,
-                                bool in_is_image_mono) = 0;
-    virtual void view_mouse_info_updated(bool in_is_valid_mouse_info,
-                                            int in_mouse_x, int in_mouse_y,
-                                            bool in_is_mouse_mono,
-                                            int in_mouse_r, int in_mouse_g, int in_mouse_b) = 0;
-    virtual void view_frame_info_updated(bool in_is_valid_frame_info,
-                                        unsigned int in_frame_count, double in_fps) = 0;
+    PerfCounter()
+    {
+      m_start_count = 0;
+    }
+    virtual ~PerfCounter() = default;
+    uint64_t  get_count()
+    {
+      struct timespec tp;
+      if (clock_gettime(CLOCK_REALTIME, &tp) < 0)
+      {
+        SHL_ERROR_OUT("clock_gettime() returned error: %d", errno);
+        return 0;
+      }
+      uint64_t v = (uint64_t )tp.tv_nsec;
+      v += (uint64_t )tp.tv_sec * 1000000000L;
+      return v;
+    }
+    void start_count()
+    {
+      m_start_count = get_count();
+    }
+    uint64_t  elapsed_time()
+    {
+      return get_count() - m_start_count;
+    }
+
+  private:
+    uint64_t  m_start_count;
   };
 
   // ===========================================================================
-  // View class
+  //  Converter class - pixel format conversion utility class
   // ===========================================================================
-  // Note: Order of Scrollable -> Widget is very important
-  //
-  class View : virtual public Gtk::Scrollable, virtual public Gtk::Widget
+  class Converter
   {
-    // Class related macros
-#define IM_VIEW_COLORMAP_COLOR_NUM      256
-#define IM_VIEW_COLORMAP_DATA_SIZE      (IM_VIEW_COLORMAP_COLOR_NUM * 3)
-
   public:
+    // Constants ---------------------------------------------------------------
+    static constexpr size_t MONO16_LUT_SIZE = 65536;
+
+    // Static Functions --------------------------------------------------------
     // -------------------------------------------------------------------------
-    // View destructor
+    // make_window_level_lut
     // -------------------------------------------------------------------------
-    ~View() override
+    // Builds the table that maps a pixel value (16bit by default) to a colormap
+    // index (0-255). The values in [in_level - in_window / 2, in_level + in_window / 2) are
+    // mapped linearly and the values outside of the range are saturated.
+    //
+    static void make_window_level_lut(int in_window, int in_level, uint8_t *out_lut,
+                                      size_t in_lut_size = MONO16_LUT_SIZE)
     {
-      SHL_DBG_OUT("View was deleted");
+      if (in_window < 1)
+        in_window = 1;
+      int64_t low = (int64_t )in_level - in_window / 2;
+      for (int64_t i = 0; i < (int64_t )in_lut_size; i++)
+      {
+        int64_t v = ((i - low) * 256) / in_window;
+        if (v < 0)
+          v = 0;
+        if (v > 255)
+          v = 255;
+        out_lut[i] = (uint8_t )v;
+      }
     }
-
-  protected:
     // -------------------------------------------------------------------------
-    // View constructor
+    // mono8_to_rgb
     // -------------------------------------------------------------------------
-    View() :
-            Glib::ObjectBase("View"),
-            m_h_adjustment(*this, "hadjustment"),
-            m_v_adjustment(*this, "vadjustment"),
-            m_h_scroll_policy(*this, "hscroll-policy", Gtk::SCROLL_NATURAL),
-            m_v_scroll_policy(*this, "vscroll-policy", Gtk::SCROLL_NATURAL)
+    static void mono8_to_rgb(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                             const uint8_t *in_colormap)
     {
-      set_has_window(true);
-      property_hadjustment().signal_changed().connect(sigc::mem_fun(
-              *this, &shl::gtk::image::View::h_adjustment_changed));
-      property_vadjustment().signal_changed().connect(sigc::mem_fun(
-              *this, &shl::gtk::image::View::v_adjustment_changed));
-
-      m_width = 0;
-      m_height = 0;
-      m_org_width = 0;
-      m_org_height = 0;
-      m_mouse_x = 0;
-      m_mouse_y = 0;
-      m_mouse_info_x = 0;
-      m_mouse_info_y = 0;
-      m_mouse_info_updated = false;
-      m_offset_x = 0;
-      m_offset_y = 0;
-      m_offset_x_max = 0;
-      m_offset_y_max = 0;
-      m_offset_x_org = 0;
-      m_offset_y_org = 0;
-      m_window_x = 0;
-      m_window_y = 0;
-      m_window_width = 0;
-      m_window_height = 0;
-      m_zoom = 1.0;
-      m_zoom_best_fit = false;
-      m_mouse_l_pressed = false;
-      m_adjustments_modified = false;
-
-      m_image_data_ptr = nullptr;
-      m_is_image_size_changed = false;
-
-      m_fps = 0;
-      m_fps_sum = 0;
-      m_fps_sum_num = 0;
-
-      m_colormap_index = Colormap::COLORMAP_NOT_SPECIFIED;
-      std::memset(m_colormap, 0, IM_VIEW_COLORMAP_DATA_SIZE);
-
-      add_events(Gdk::SCROLL_MASK |
-                 Gdk::BUTTON_MOTION_MASK | Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK |
-                 Gdk::POINTER_MOTION_MASK | Gdk::LEAVE_NOTIFY_MASK);
+      for (size_t i = 0; i < in_num; i++)
+      {
+        const uint8_t *rgb = &(in_colormap[in_src[i] * 3]);
+        out_dst[0] = rgb[0];
+        out_dst[1] = rgb[1];
+        out_dst[2] = rgb[2];
+        out_dst += 3;
+      }
     }
-
-    // Member functions --------------------------------------------------------
     // -------------------------------------------------------------------------
-    // set_image_data
+    // make_rgb_lut32
     // -------------------------------------------------------------------------
-    void set_image_data(Data *inImageDataPtr)
+    // Packs the 256 entries RGB colormap into the 32bit entries (R, G, B, 0 in
+    // the memory order) for mono8_lut_to_rgb()
+    //
+    static void make_rgb_lut32(const uint8_t *in_colormap, uint32_t *out_lut32)
     {
-      m_image_data_ptr = inImageDataPtr;
-      queue_draw();
+      for (int i = 0; i < 256; i++)
+      {
+        const uint8_t *rgb = &(in_colormap[i * 3]);
+        uint8_t entry[4] = {rgb[0], rgb[1], rgb[2], 0};
+        ::memcpy(&(out_lut32[i]), entry, sizeof(uint32_t));
+      }
     }
     // -------------------------------------------------------------------------
-    // get_image_data
+    // make_rgb_lut32
     // -------------------------------------------------------------------------
-    Data *get_image_data()
+    // Folds the 256 entries index table (e.g. made by make_window_level_lut())
+    // into the packed colormap, so that mono8_lut_to_rgb() still takes one
+    // lookup per pixel
+    //
+    static void make_rgb_lut32(const uint8_t *in_colormap, const uint8_t *in_index_lut,
+                               uint32_t *out_lut32)
     {
-      return m_image_data_ptr;
+      for (int i = 0; i < 256; i++)
+      {
+        const uint8_t *rgb = &(in_colormap[in_index_lut[i] * 3]);
+        uint8_t entry[4] = {rgb[0], rgb[1], rgb[2], 0};
+        ::memcpy(&(out_lut32[i]), entry, sizeof(uint32_t));
+      }
     }
     // -------------------------------------------------------------------------
-    // add_update_handler
+    // mono8_lut_to_rgb
     // -------------------------------------------------------------------------
-    void add_update_handler(UpdateHandlerInterface *in_handler)
+    // Expands the MONO8 row to RGB8 through the colormap made by
+    // make_rgb_lut32(). The fastest kernel for the CPU (AVX2, SSE4.1 or
+    // scalar) is selected on the first call
+    //
+    static void mono8_lut_to_rgb(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                                 const uint32_t *in_lut32)
     {
-      m_update_handlers.push_back(in_handler);
+      static const Mono8LutFunc func = select_mono8_lut_to_rgb();
+      func(in_src, out_dst, in_num, in_lut32);
     }
     // -------------------------------------------------------------------------
-    // remove_update_handler
+    // mono8_lut_to_rgb_scalar
     // -------------------------------------------------------------------------
-    void remove_update_handler(UpdateHandlerInterface *in_handler)
+    static void mono8_lut_to_rgb_scalar(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                                        const uint32_t *in_lut32)
     {
-      auto it = std::find(m_update_handlers.begin(),
-                          m_update_handlers.end(),
-                          in_handler);
-      if (it == m_update_handlers.end())
-        return;
-      m_update_handlers.erase(it);
+      size_t i = 0;
+      // Writes 4 bytes per pixel (the 4th byte is overwritten by the next pixel)
+      for (; i + 1 < in_num; i++, out_dst += 3)
+        ::memcpy(out_dst, &(in_lut32[in_src[i]]), sizeof(uint32_t));
+      for (; i < in_num; i++, out_dst += 3)
+      {
+        const auto *rgb = (const uint8_t *)&(in_lut32[in_src[i]]);
+        out_dst[0] = rgb[0];
+        out_dst[1] = rgb[1];
+        out_dst[2] = rgb[2];
+      }
     }
     // -------------------------------------------------------------------------
-    // get_zoom
+    // mono16_to_rgb
     // -------------------------------------------------------------------------
-    double get_zoom()
+    static void mono16_to_rgb(const uint16_t *in_src, uint8_t *out_dst, size_t in_num,
+                              const uint8_t *in_lut, const uint8_t *in_colormap)
     {
-      return m_zoom;
+      for (size_t i = 0; i < in_num; i++)
+      {
+        const uint8_t *rgb = &(in_colormap[in_lut[in_src[i]] * 3]);
+        out_dst[0] = rgb[0];
+        out_dst[1] = rgb[1];
+        out_dst[2] = rgb[2];
+        out_dst += 3;
+      }
     }
     // -------------------------------------------------------------------------
-    // set_zoom
+    // bgra_to_rgb24
     // -------------------------------------------------------------------------
-    void set_zoom(double in_zoom)
+    // Converts to the native 32bit xRGB pixel of Cairo (Cairo::FORMAT_RGB24)
+    //
+    static void bgra_to_rgb24(const uint8_t *in_src, uint8_t *out_dst, size_t in_num)
     {
-      set_zoom(in_zoom, m_window_width / 2.0, m_window_height / 2.0);
+      auto *dst = (uint32_t *)out_dst;
+      for (size_t i = 0; i < in_num; i++, in_src += 4)
+        dst[i] = 0xFF000000 | (in_src[2] << 16) | (in_src[1] << 8) | in_src[0];
     }
     // -------------------------------------------------------------------------
-    // get_zoom_best_fit
+    // rgba_to_rgb24
     // -------------------------------------------------------------------------
-    bool get_zoom_best_fit() const
+    static void rgba_to_rgb24(const uint8_t *in_src, uint8_t *out_dst, size_t in_num)
     {
-      return m_zoom_best_fit;
+      auto *dst = (uint32_t *)out_dst;
+      size_t i = 0;
+#ifdef SHL_IMAGE_USE_SSE2
+      // x86 is little endian : swap the byte 0 and the byte 2 of each pixel
+      const __m128i mask_g = _mm_set1_epi32(0x0000FF00);
+      const __m128i mask_b = _mm_set1_epi32(0x000000FF);
+      const __m128i alpha = _mm_set1_epi32((int )0xFF000000);
+      for (; i + 4 <= in_num; i += 4, in_src += 16)
+      {
+        __m128i v = _mm_loadu_si128((const __m128i *)in_src);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), mask_b);
+        __m128i b = _mm_slli_epi32(_mm_and_si128(v, mask_b), 16);
+        v = _mm_or_si128(_mm_or_si128(_mm_and_si128(v, mask_g), alpha),
+                         _mm_or_si128(r, b));
+        _mm_storeu_si128((__m128i *)(dst + i), v);
+      }
+#endif
+      for (; i < in_num; i++, in_src += 4)
+        dst[i] = 0xFF000000 | (in_src[0] << 16) | (in_src[1] << 8) | in_src[2];
+    }
+    // -------------------------------------------------------------------------
+    // bgr_to_rgb24
+    // -------------------------------------------------------------------------
+    static void bgr_to_rgb24(const uint8_t *in_src, uint8_t *out_dst, size_t in_num)
+    {
+      auto *dst = (uint32_t *)out_dst;
+      for (size_t i = 0; i < in_num; i++, in_src += 3)
+        dst[i] = 0xFF000000 | (in_src[2] << 16) | (in_src[1] << 8) | in_src[0];
+    }
+    // -------------------------------------------------------------------------
+    // downscale_half_to_rgb24
+    // -------------------------------------------------------------------------
+    // Averages the 2x2 pixels of in_row0 and in_row1 into one Cairo RGB24
+    // pixel. in_pixel_size is 3 for the RGB8 rows (pixbuf) and 4 for the
+    // Cairo RGB24 rows (surface or the previous mipmap level)
+    //
+    static void downscale_half_to_rgb24(const uint8_t *in_row0, const uint8_t *in_row1,
+                                        size_t in_pixel_size, uint8_t *out_dst, size_t in_num)
+    {
+      size_t done = 0;
+#ifdef SHL_IMAGE_USE_SSE2
+      if (in_pixel_size == 4)
+        done = downscale_half_rgb24_sse2(in_row0, in_row1, out_dst, in_num);
+#endif
+#ifdef SHL_IMAGE_USE_RUNTIME_DISPATCH
+      if (in_pixel_size == 3 && is_ssse3_supported())
+        done = downscale_half_rgb_ssse3(in_row0, in_row1, out_dst, in_num);
+#endif
+      size_t offset = done * in_pixel_size * 2;
+      downscale_half_to_rgb24_scalar(in_row0 + offset, in_row1 + offset, in_pixel_size,
+                                     out_dst + done * 4, in_num - done);
+    }
+    // -------------------------------------------------------------------------
+    // downscale_half_to_rgb24_scalar
+    // -------------------------------------------------------------------------
+    static void downscale_half_to_rgb24_scalar(const uint8_t *in_row0, const uint8_t *in_row1,
+                                               size_t in_pixel_size, uint8_t *out_dst, size_t in_num)
+    {
+      auto *dst = (uint32_t *)out_dst;
+      size_t step = in_pixel_size * 2;
+      // The byte order of the RGB8 pixel is the reverse of the RGB24 pixel
+      int r = (in_pixel_size == 3) ? 0 : 2;
+      int b = 2 - r;
+      for (size_t i = 0; i < in_num; i++, in_row0 += step, in_row1 += step)
+      {
+        const uint8_t *p0 = in_row0;
+        const uint8_t *p1 = in_row1;
+        const size_t n = in_pixel_size;
+        uint32_t vr = (p0[r] + p0[r + n] + p1[r] + p1[r + n] + 2) >> 2;
+        uint32_t vg = (p0[1] + p0[1 + n] + p1[1] + p1[1 + n] + 2) >> 2;
+        uint32_t vb = (p0[b] + p0[b + n] + p1[b] + p1[b + n] + 2) >> 2;
+        dst[i] = 0xFF000000 | (vr << 16) | (vg << 8) | vb;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // AreaWeights
+    // -------------------------------------------------------------------------
+    // The weights of the source pixels covered by each destination pixel
+    // (the area average of the span [i * ratio, (i + 1) * ratio))
+    //
+    struct AreaWeights
+    {
+      int tap_num = 0;
+      std::vector<int> start;
+      std::vector<int> count;
+      std::vector<float> weights;   // tap_num entries for each destination pixel
+    };
+    // -------------------------------------------------------------------------
+    // make_area_weights
+    // -------------------------------------------------------------------------
+    static void make_area_weights(int in_src_size, int in_dst_size, AreaWeights *out_weights)
+    {
+      double ratio = (double )in_src_size / in_dst_size;
+      int tap_num = (int )ceil(ratio) + 1;
+      out_weights->tap_num = tap_num;
+      out_weights->start.assign(in_dst_size, 0);
+      out_weights->count.assign(in_dst_size, 0);
+      out_weights->weights.assign((size_t )in_dst_size * tap_num, 0.0f);
+      for (int i = 0; i < in_dst_size; i++)
+      {
+        double x0 = i * ratio;
+        double x1 = (i + 1) * ratio;
+        int j0 = (int )floor(x0);
+        out_weights->start[i] = j0;
+        for (int t = 0; t < tap_num && j0 + t < in_src_size; t++)
+        {
+          double w = std::min((double )(j0 + t + 1), x1) - std::max((double )(j0 + t), x0);
+          if (w <= 0)
+            break;
+          out_weights->weights[(size_t )i * tap_num + t] = (float )(w / ratio);
+          out_weights->count[i] = t + 1;
+        }
+      }
+    }
+    // -------------------------------------------------------------------------
+    // area_downscale_row
+    // -------------------------------------------------------------------------
+    // Horizontal pass : averages the source row into 4 floats (B, G, R, x)
+    // for each destination pixel. in_pixel_size is 3 (RGB8) or 4 (RGB24)
+    //
+    static void area_downscale_row(const uint8_t *in_src, size_t in_pixel_size,
+                                   const AreaWeights &in_weights, float *out_row, int in_num)
+    {
+      int r = (in_pixel_size == 3) ? 0 : 2;
+      int b = 2 - r;
+      for (int i = 0; i < in_num; i++, out_row += 4)
+      {
+        const uint8_t *src = in_src + (size_t )in_weights.start[i] * in_pixel_size;
+        const float *w = &(in_weights.weights[(size_t )i * in_weights.tap_num]);
+        int count = in_weights.count[i];
+#ifdef SHL_IMAGE_USE_SSE2
+        __m128 acc = _mm_setzero_ps();
+        for (int t = 0; t < count; t++, src += in_pixel_size)
+        {
+          __m128 v = _mm_cvtepi32_ps(_mm_setr_epi32(src[b], src[1], src[r], 0));
+          acc = _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(w[t])));
+        }
+        _mm_storeu_ps(out_row, acc);
+#else
+        float acc[4] = {0, 0, 0, 0};
+        for (int t = 0; t < count; t++, src += in_pixel_size)
+        {
+          acc[0] += src[b] * w[t];
+          acc[1] += src[1] * w[t];
+          acc[2] += src[r] * w[t];
+        }
+        ::memcpy(out_row, acc, sizeof(acc));
+#endif
+      }
+    }
+    // -------------------------------------------------------------------------
+    // accumulate_row
+    // -------------------------------------------------------------------------
+    // Vertical pass : io_acc += in_row * in_weight
+    //
+    static void accumulate_row(const float *in_row, float in_weight, float *io_acc, size_t in_num)
+    {
+      size_t i = 0;
+#ifdef SHL_IMAGE_USE_SSE2
+      const __m128 w = _mm_set1_ps(in_weight);
+      for (; i + 4 <= in_num; i += 4)
+        _mm_storeu_ps(io_acc + i, _mm_add_ps(_mm_loadu_ps(io_acc + i),
+                                             _mm_mul_ps(_mm_loadu_ps(in_row + i), w)));
+#endif
+      for (; i < in_num; i++)
+        io_acc[i] += in_row[i] * in_weight;
+    }
+    // -------------------------------------------------------------------------
+    // store_rgb24_row
+    // -------------------------------------------------------------------------
+    // Rounds the accumulated (B, G, R, x) floats to the Cairo RGB24 pixels
+    //
+    static void store_rgb24_row(const float *in_acc, uint8_t *out_dst, int in_num)
+    {
+      auto *dst = (uint32_t *)out_dst;
+      int i = 0;
+#ifdef SHL_IMAGE_USE_SSE2
+      const __m128i alpha = _mm_set1_epi32((int )0xFF000000);
+      for (; i + 4 <= in_num; i += 4, in_acc += 16)
+      {
+        __m128i p0 = _mm_cvtps_epi32(_mm_loadu_ps(in_acc));
+        __m128i p1 = _mm_cvtps_epi32(_mm_loadu_ps(in_acc + 4));
+        __m128i p2 = _mm_cvtps_epi32(_mm_loadu_ps(in_acc + 8));
+        __m128i p3 = _mm_cvtps_epi32(_mm_loadu_ps(in_acc + 12));
+        __m128i v = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_or_si128(v, alpha));
+      }
+#endif
+      for (; i < in_num; i++, in_acc += 4)
+      {
+        uint32_t v[3];
+        for (int c = 0; c < 3; c++)
+        {
+          float f = in_acc[c] + 0.5f;
+          v[c] = (f <= 0) ? 0 : ((f >= 255) ? 255 : (uint32_t )f);
+        }
+        dst[i] = 0xFF000000 | (v[2] << 16) | (v[1] << 8) | v[0];
+      }
+    }
+    // -------------------------------------------------------------------------
+    // load_rgb24
+    // -------------------------------------------------------------------------
+    // A pixel of the RGB8 (in_pixel_size == 3) or the Cairo RGB24 row as the
+    // Cairo RGB24 pixel
+    //
+    static uint32_t load_rgb24(const uint8_t *in_src, size_t in_pixel_size)
+    {
+      if (in_pixel_size == 4)
+      {
+        uint32_t v;
+        ::memcpy(&v, in_src, 4);
+        return v;
+      }
+      return 0xFF000000 | ((uint32_t )in_src[0] << 16) | ((uint32_t )in_src[1] << 8) | in_src[2];
+    }
+    // -------------------------------------------------------------------------
+    // expand_row_nearest
+    // -------------------------------------------------------------------------
+    // Nearest neighbour expansion for any zoom : out_dst[i] = in_src[in_x_index[i]]
+    //
+    static void expand_row_nearest(const uint8_t *in_src, size_t in_pixel_size,
+                                   const int *in_x_index, uint8_t *out_dst, int in_num)
+    {
+      auto *dst = (uint32_t *)out_dst;
+      int i = 0;
+      while (i < in_num)
+      {
+        // The runs of the same source pixel
+        int index = in_x_index[i];
+        uint32_t v = load_rgb24(in_src + (size_t )index * in_pixel_size, in_pixel_size);
+        for (; i < in_num && in_x_index[i] == index; i++)
+          dst[i] = v;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // expand_row_integer
+    // -------------------------------------------------------------------------
+    // Pixel replication for the integer zoom. Each source pixel is repeated
+    // in_zoom times except the first one (in_zoom - in_phase times)
+    //
+    static void expand_row_integer(const uint8_t *in_src, size_t in_pixel_size,
+                                   int in_zoom, int in_phase, uint8_t *out_dst, int in_num)
+    {
+      auto *dst = (uint32_t *)out_dst;
+      if (in_zoom == 1 && in_pixel_size == 4)
+      {
+        ::memcpy(out_dst, in_src, (size_t )in_num * 4);
+        return;
+      }
+      int i = 0;
+      // The first (partial) run
+      uint32_t v = load_rgb24(in_src, in_pixel_size);
+      for (; i < in_num && i < in_zoom - in_phase; i++)
+        dst[i] = v;
+      in_src += in_pixel_size;
+#ifdef SHL_IMAGE_USE_SSE2
+      if (in_pixel_size == 4 && in_zoom == 2)
+      {
+        for (; i + 8 <= in_num; i += 8, in_src += 16)
+        {
+          __m128i p = _mm_loadu_si128((const __m128i *)in_src);
+          _mm_storeu_si128((__m128i *)(dst + i), _mm_unpacklo_epi32(p, p));
+          _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_unpackhi_epi32(p, p));
+        }
+      }
+      else if (in_pixel_size == 4 && in_zoom == 4)
+      {
+        for (; i + 16 <= in_num; i += 16, in_src += 16)
+        {
+          __m128i p = _mm_loadu_si128((const __m128i *)in_src);
+          _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi32(p, 0x00));
+          _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_shuffle_epi32(p, 0x55));
+          _mm_storeu_si128((__m128i *)(dst + i + 8), _mm_shuffle_epi32(p, 0xAA));
+          _mm_storeu_si128((__m128i *)(dst + i + 12), _mm_shuffle_epi32(p, 0xFF));
+        }
+      }
+      else if (in_zoom >= 8)
+      {
+        for (; i + in_zoom <= in_num; in_src += in_pixel_size)
+        {
+          __m128i p = _mm_set1_epi32((int )load_rgb24(in_src, in_pixel_size));
+          int end = i + in_zoom;
+          for (; i + 4 <= end; i += 4)
+            _mm_storeu_si128((__m128i *)(dst + i), p);
+          for (; i < end; i++)
+            dst[i] = (uint32_t )_mm_cvtsi128_si32(p);
+        }
+      }
+#endif
+      // The rest (and the other zoom factors)
+      while (i < in_num)
+      {
+        v = load_rgb24(in_src, in_pixel_size);
+        int end = std::min(i + in_zoom, in_num);
+        for (; i < end; i++)
+          dst[i] = v;
+        in_src += in_pixel_size;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // YUVCoefficients
+    // -------------------------------------------------------------------------
+    // The limited range YUV to RGB matrix in Q13 fixed point
+    //  R = cy * (Y - 16) + r_v * (V - 128)
+    //  G = cy * (Y - 16) - g_u * (U - 128) - g_v * (V - 128)
+    //  B = cy * (Y - 16) + b_u * (U - 128)
+    //
+    struct YUVCoefficients
+    {
+      int16_t y;
+      int16_t r_v;
+      int16_t g_u;
+      int16_t g_v;
+      int16_t b_u;
+    };
+    // -------------------------------------------------------------------------
+    // get_yuv_coefficients
+    // -------------------------------------------------------------------------
+    static const YUVCoefficients &get_yuv_coefficients(bool in_is_bt709)
+    {
+      static const YUVCoefficients bt601 = {9539, 13075, 3209, 6660, 16525};
+      static const YUVCoefficients bt709 = {9539, 14686, 1747, 4366, 17305};
+      if (in_is_bt709)
+        return bt709;
+      return bt601;
+    }
+    // -------------------------------------------------------------------------
+    // yuv422_to_rgb24
+    // -------------------------------------------------------------------------
+    // Converts the packed 4:2:2 row (YUYV or UYVY) to the Cairo::FORMAT_RGB24
+    // pixels. in_num needs to be even
+    //
+    static void yuv422_to_rgb24(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                                bool in_is_uyvy, const YUVCoefficients &in_coeffs)
+    {
+      auto *dst = (uint32_t *)out_dst;
+      size_t i = 0;
+      int y_pos = in_is_uyvy ? 1 : 0;
+      int c_pos = in_is_uyvy ? 0 : 1;
+#ifdef SHL_IMAGE_USE_SSE2
+      const __m128i mask_lo = _mm_set1_epi16(0x00FF);
+      for (; i + 8 <= in_num; i += 8, in_src += 16)
+      {
+        __m128i v = _mm_loadu_si128((const __m128i *)in_src);
+        __m128i y, c;
+        if (in_is_uyvy)
+        {
+          y = _mm_srli_epi16(v, 8);
+          c = _mm_and_si128(v, mask_lo);
+        }
+        else
+        {
+          y = _mm_and_si128(v, mask_lo);
+          c = _mm_srli_epi16(v, 8);
+        }
+        // c : U0 V0 U1 V1 U2 V2 U3 V3 -> U0 U0 U1 U1 ... and V0 V0 V1 V1 ...
+        __m128i u = _mm_and_si128(c, _mm_set1_epi32(0x0000FFFF));
+        __m128i w = _mm_srli_epi32(c, 16);
+        u = _mm_or_si128(u, _mm_slli_epi32(u, 16));
+        w = _mm_or_si128(w, _mm_slli_epi32(w, 16));
+        yuv_to_rgb24_x8(y, u, w, in_coeffs, dst + i);
+      }
+#endif
+      for (; i + 2 <= in_num; i += 2, in_src += 4)
+      {
+        dst[i] = yuv_to_rgb24(in_src[y_pos], in_src[c_pos], in_src[c_pos + 2], in_coeffs);
+        dst[i + 1] = yuv_to_rgb24(in_src[y_pos + 2], in_src[c_pos], in_src[c_pos + 2],
+                                  in_coeffs);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // yuv420_to_rgb24
+    // -------------------------------------------------------------------------
+    // Converts the row of the planar 4:2:0 image to the Cairo::FORMAT_RGB24
+    // pixels. in_uv_step is the distance between the chroma samples
+    // (2 for the interleaved NV12 plane, 1 for the I420 planes)
+    //
+    static void yuv420_to_rgb24(const uint8_t *in_y, const uint8_t *in_u, const uint8_t *in_v,
+                                size_t in_uv_step, uint8_t *out_dst, size_t in_num,
+                                const YUVCoefficients &in_coeffs)
+    {
+      auto *dst = (uint32_t *)out_dst;
+      size_t i = 0;
+#ifdef SHL_IMAGE_USE_SSE2
+      const __m128i zero = _mm_setzero_si128();
+      for (; i + 8 <= in_num; i += 8)
+      {
+        __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(in_y + i)), zero);
+        __m128i u, v;
+        if (in_uv_step == 2)
+        {
+          __m128i c = _mm_unpacklo_epi8(
+                  _mm_loadl_epi64((const __m128i *)(in_u + i)), zero);
+          u = _mm_and_si128(c, _mm_set1_epi32(0x0000FFFF));
+          v = _mm_srli_epi32(c, 16);
+          u = _mm_or_si128(u, _mm_slli_epi32(u, 16));
+          v = _mm_or_si128(v, _mm_slli_epi32(v, 16));
+        }
+        else
+        {
+          int32_t u4, v4;
+          ::memcpy(&u4, in_u + i / 2, sizeof(u4));
+          ::memcpy(&v4, in_v + i / 2, sizeof(v4));
+          u = _mm_unpacklo_epi8(_mm_cvtsi32_si128(u4), zero);
+          v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v4), zero);
+          u = _mm_unpacklo_epi16(u, u);
+          v = _mm_unpacklo_epi16(v, v);
+        }
+        yuv_to_rgb24_x8(y, u, v, in_coeffs, dst + i);
+      }
+#endif
+      for (; i < in_num; i++)
+      {
+        size_t c = (i / 2) * in_uv_step;
+        dst[i] = yuv_to_rgb24(in_y[i], in_u[c], in_v[c], in_coeffs);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // bayer_bilinear_to_rgb
+    // -------------------------------------------------------------------------
+    // Demosaics the row in_y of the Bayer image with the bilinear interpolation.
+    // in_r_x and in_r_y specify the position of the red pixel in the 2x2 cell.
+    // The pixels outside of the image are mirrored (keeps the color phase)
+    //
+    static void bayer_bilinear_to_rgb(const uint8_t *in_src, size_t in_stride,
+                                      int in_width, int in_height, int in_y,
+                                      int in_r_x, int in_r_y, uint8_t *out_dst)
+    {
+      int y_up = in_y - 1, y_down = in_y + 1;
+      if (y_up < 0)
+        y_up = (in_height > 1) ? 1 : 0;
+      if (y_down >= in_height)
+        y_down = (in_height > 1) ? in_height - 2 : 0;
+      const uint8_t *cur = in_src + in_y * in_stride;
+      const uint8_t *up = in_src + y_up * in_stride;
+      const uint8_t *down = in_src + y_down * in_stride;
+      // In the red rows the non-green pixels are red, otherwise blue
+      bool is_red_row = ((in_y & 1) == in_r_y);
+      int color_x = is_red_row ? in_r_x : (in_r_x ^ 1);
+      int last = in_width - 1;
+
+      for (int x = 0; x < in_width; x++, out_dst += 3)
+      {
+        int xl = x - 1, xr = x + 1;
+        if (xl < 0)
+          xl = (in_width > 1) ? 1 : 0;
+        if (xr > last)
+          xr = (in_width > 1) ? last - 1 : 0;
+        int row_color, other_color, green;
+        if ((x & 1) == color_x)
+        {
+          row_color = cur[x];
+          green = (cur[xl] + cur[xr] + up[x] + down[x] + 2) >> 2;
+          other_color = (up[xl] + up[xr] + down[xl] + down[xr] + 2) >> 2;
+        }
+        else
+        {
+          row_color = (cur[xl] + cur[xr] + 1) >> 1;
+          green = cur[x];
+          other_color = (up[x] + down[x] + 1) >> 1;
+        }
+        out_dst[0] = (uint8_t )(is_red_row ? row_color : other_color);
+        out_dst[1] = (uint8_t )green;
+        out_dst[2] = (uint8_t )(is_red_row ? other_color : row_color);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // bayer_nearest_to_rgb
+    // -------------------------------------------------------------------------
+    // Fills each pixel with the colors of its 2x2 Bayer cell (preview quality)
+    //
+    static void bayer_nearest_to_rgb(const uint8_t *in_src, size_t in_stride,
+                                     int in_width, int in_height, int in_y,
+                                     int in_r_x, int in_r_y, uint8_t *out_dst)
+    {
+      if (in_width < 2 || in_height < 2)
+      {
+        ::memset(out_dst, in_src[in_y * in_stride], in_width * 3);
+        return;
+      }
+      // The incomplete cells at the right and the bottom edges use the last
+      // complete cell
+      int cell_y = in_y & ~1;
+      if (cell_y + 1 >= in_height)
+        cell_y = (in_height - 2) & ~1;
+      const uint8_t *red_row = in_src + (cell_y + in_r_y) * in_stride;
+      const uint8_t *blue_row = in_src + (cell_y + (in_r_y ^ 1)) * in_stride;
+
+      for (int x = 0; x < in_width; x++, out_dst += 3)
+      {
+        int cell_x = x & ~1;
+        if (cell_x + 1 >= in_width)
+          cell_x = (in_width - 2) & ~1;
+        out_dst[0] = red_row[cell_x + in_r_x];
+        out_dst[1] = red_row[cell_x + (in_r_x ^ 1)];
+        out_dst[2] = blue_row[cell_x + (in_r_x ^ 1)];
+      }
+    }
+    // -------------------------------------------------------------------------
+    // mono32f_min_max
+    // -------------------------------------------------------------------------
+    // Finds the range of the finite values (NaN and +/-Inf are skipped).
+    // Returns false when there is no finite value in the buffer
+    //
+    static bool mono32f_min_max(const float *in_src, size_t in_num,
+                                float *out_min, float *out_max)
+    {
+      float min_v = FLT_MAX;
+      float max_v = -FLT_MAX;
+      size_t i = 0;
+#ifdef SHL_IMAGE_USE_SSE2
+      __m128 v_min = _mm_set1_ps(FLT_MAX);
+      __m128 v_max = _mm_set1_ps(-FLT_MAX);
+      const __m128 v_zero = _mm_setzero_ps();
+      for (; i + 4 <= in_num; i += 4)
+      {
+        __m128 v = _mm_loadu_ps(in_src + i);
+        // (v - v) is 0 only for finite values (NaN and Inf give NaN)
+        __m128 finite = _mm_cmpeq_ps(_mm_sub_ps(v, v), v_zero);
+        v_min = _mm_min_ps(v_min, _mm_or_ps(_mm_and_ps(finite, v),
+                                            _mm_andnot_ps(finite, v_min)));
+        v_max = _mm_max_ps(v_max, _mm_or_ps(_mm_and_ps(finite, v),
+                                            _mm_andnot_ps(finite, v_max)));
+      }
+      float buf_min[4], buf_max[4];
+      _mm_storeu_ps(buf_min, v_min);
+      _mm_storeu_ps(buf_max, v_max);
+      for (int j = 0; j < 4; j++)
+      {
+        if (buf_min[j] < min_v)
+          min_v = buf_min[j];
+        if (buf_max[j] > max_v)
+          max_v = buf_max[j];
+      }
+#endif
+      for (; i < in_num; i++)
+      {
+        float v = in_src[i];
+        if (std::isfinite(v) == false)
+          continue;
+        if (v < min_v)
+          min_v = v;
+        if (v > max_v)
+          max_v = v;
+      }
+      if (min_v > max_v)
+        return false;
+      *out_min = min_v;
+      *out_max = max_v;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // mono32f_to_rgb
+    // -------------------------------------------------------------------------
+    // Maps [in_min, in_max] to the colormap (NaN and -Inf go to the first
+    // entry and +Inf goes to the last entry)
+    //
+    static void mono32f_to_rgb(const float *in_src, uint8_t *out_dst, size_t in_num,
+                               double in_min, double in_max, const uint8_t *in_colormap)
+    {
+      if (in_max <= in_min)
+        in_max = in_min + 1.0;
+      const float min_v = (float )in_min;
+      const float scale = (float )(256.0 / (in_max - in_min));
+      for (size_t i = 0; i < in_num; i++)
+      {
+        float t = (in_src[i] - min_v) * scale;
+        int index = 0;
+        if (t >= 255.0f)
+          index = 255;
+        else if (t > 0.0f)
+          index = (int )t;
+        const uint8_t *rgb = &(in_colormap[index * 3]);
+        out_dst[0] = rgb[0];
+        out_dst[1] = rgb[1];
+        out_dst[2] = rgb[2];
+        out_dst += 3;
+      }
+    }
+
+  protected:
+    // Typedefs ----------------------------------------------------------------
+    typedef void (*Mono8LutFunc)(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                                 const uint32_t *in_lut32);
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // select_mono8_lut_to_rgb
+    // -------------------------------------------------------------------------
+    static Mono8LutFunc select_mono8_lut_to_rgb()
+    {
+#ifdef SHL_IMAGE_USE_RUNTIME_DISPATCH
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+        return mono8_lut_to_rgb_avx2;
+      if (__builtin_cpu_supports("sse4.1"))
+        return mono8_lut_to_rgb_sse41;
+#endif
+      return mono8_lut_to_rgb_scalar;
+    }
+#ifdef SHL_IMAGE_USE_SSE2
+    // -------------------------------------------------------------------------
+    // downscale_half_rgb24_sse2
+    // -------------------------------------------------------------------------
+    // 4 destination pixels per iteration. Returns the number of the pixels done
+    //
+    static size_t downscale_half_rgb24_sse2(const uint8_t *in_row0, const uint8_t *in_row1,
+                                            uint8_t *out_dst, size_t in_num)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i two = _mm_set1_epi16(2);
+      const __m128i alpha = _mm_set1_epi32((int )0xFF000000);
+      size_t i = 0;
+      for (; i + 4 <= in_num; i += 4, in_row0 += 32, in_row1 += 32)
+      {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)in_row0);
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(in_row0 + 16));
+        __m128i b0 = _mm_loadu_si128((const __m128i *)in_row1);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(in_row1 + 16));
+        // The vertical sums of 2 pixels in each register (16bit x 4ch x 2)
+        __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+        // The horizontal sums of the neighbouring pixels
+        __m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        __m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+        h0 = _mm_srli_epi16(_mm_add_epi16(h0, two), 2);
+        h1 = _mm_srli_epi16(_mm_add_epi16(h1, two), 2);
+        _mm_storeu_si128((__m128i *)(out_dst + i * 4),
+                         _mm_or_si128(_mm_packus_epi16(h0, h1), alpha));
+      }
+      return i;
+    }
+#endif
+#ifdef SHL_IMAGE_USE_RUNTIME_DISPATCH
+    // -------------------------------------------------------------------------
+    // is_ssse3_supported
+    // -------------------------------------------------------------------------
+    static bool is_ssse3_supported()
+    {
+      static const bool s_supported = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+      return s_supported;
+    }
+    // -------------------------------------------------------------------------
+    // downscale_half_rgb_ssse3
+    // -------------------------------------------------------------------------
+    // The RGB8 version of downscale_half_rgb24_sse2. The 16 bytes loads read
+    // 4 bytes beyond the 8 source pixels, so the loop stops 1 pixel earlier
+    //
+    __attribute__((target("ssse3")))
+    static size_t downscale_half_rgb_ssse3(const uint8_t *in_row0, const uint8_t *in_row1,
+                                           uint8_t *out_dst, size_t in_num)
+    {
+      // R, G, B (3 bytes) -> B, G, R, 0 (16bit x 4)
+      const __m128i expand_lo = _mm_setr_epi8(2, -1, 1, -1, 0, -1, -1, -1,
+                                              5, -1, 4, -1, 3, -1, -1, -1);
+      const __m128i expand_hi = _mm_setr_epi8(8, -1, 7, -1, 6, -1, -1, -1,
+                                              11, -1, 10, -1, 9, -1, -1, -1);
+      const __m128i two = _mm_set1_epi16(2);
+      const __m128i alpha = _mm_set1_epi32((int )0xFF000000);
+      size_t i = 0;
+      for (; i + 5 <= in_num; i += 4, in_row0 += 24, in_row1 += 24)
+      {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)in_row0);
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(in_row0 + 12));
+        __m128i b0 = _mm_loadu_si128((const __m128i *)in_row1);
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(in_row1 + 12));
+        __m128i s0 = _mm_add_epi16(_mm_shuffle_epi8(a0, expand_lo), _mm_shuffle_epi8(b0, expand_lo));
+        __m128i s1 = _mm_add_epi16(_mm_shuffle_epi8(a0, expand_hi), _mm_shuffle_epi8(b0, expand_hi));
+        __m128i s2 = _mm_add_epi16(_mm_shuffle_epi8(a1, expand_lo), _mm_shuffle_epi8(b1, expand_lo));
+        __m128i s3 = _mm_add_epi16(_mm_shuffle_epi8(a1, expand_hi), _mm_shuffle_epi8(b1, expand_hi));
+        __m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+        __m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+        h0 = _mm_srli_epi16(_mm_add_epi16(h0, two), 2);
+        h1 = _mm_srli_epi16(_mm_add_epi16(h1, two), 2);
+        _mm_storeu_si128((__m128i *)(out_dst + i * 4),
+                         _mm_or_si128(_mm_packus_epi16(h0, h1), alpha));
+      }
+      return i;
+    }
+    // -------------------------------------------------------------------------
+    // mono8_lut_to_rgb_sse41
+    // -------------------------------------------------------------------------
+    // 4 pixels per iteration. The 16 bytes store also writes the first 4 bytes
+    // of the next 4 pixels, so the loop stops 2 pixels before the end
+    //
+    __attribute__((target("sse4.1")))
+    static void mono8_lut_to_rgb_sse41(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                                       const uint32_t *in_lut32)
+    {
+      const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                         -1, -1, -1, -1);
+      size_t i = 0;
+      for (; i + 6 <= in_num; i += 4, out_dst += 12)
+      {
+        __m128i v = _mm_cvtsi32_si128((int )in_lut32[in_src[i]]);
+        v = _mm_insert_epi32(v, (int )in_lut32[in_src[i + 1]], 1);
+        v = _mm_insert_epi32(v, (int )in_lut32[in_src[i + 2]], 2);
+        v = _mm_insert_epi32(v, (int )in_lut32[in_src[i + 3]], 3);
+        _mm_storeu_si128((__m128i *)out_dst, _mm_shuffle_epi8(v, pack));
+      }
+      mono8_lut_to_rgb_scalar(in_src + i, out_dst, in_num - i, in_lut32);
+    }
+    // -------------------------------------------------------------------------
+    // mono8_lut_to_rgb_avx2
+    // -------------------------------------------------------------------------
+    // 8 pixels per iteration with the gather. The 32 bytes store also writes
+    // the first 8 bytes of the next pixels, so the loop stops 3 pixels before
+    // the end
+    //
+    __attribute__((target("avx2")))
+    static void mono8_lut_to_rgb_avx2(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                                      const uint32_t *in_lut32)
+    {
+      const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                            -1, -1, -1, -1,
+                                            0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14,
+                                            -1, -1, -1, -1);
+      const __m256i merge = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+      size_t i = 0;
+      for (; i + 11 <= in_num; i += 8, out_dst += 24)
+      {
+        __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(in_src + i)));
+        __m256i v = _mm256_i32gather_epi32((const int *)in_lut32, index, 4);
+        v = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(v, pack), merge);
+        _mm256_storeu_si256((__m256i *)out_dst, v);
+      }
+      mono8_lut_to_rgb_scalar(in_src + i, out_dst, in_num - i, in_lut32);
+    }
+#endif
+    // -------------------------------------------------------------------------
+    // yuv_to_rgb24
+    // -------------------------------------------------------------------------
+    // The scalar version of yuv_to_rgb24_x8 (gives the same results)
+    //
+    static uint32_t yuv_to_rgb24(int in_y, int in_u, int in_v, const YUVCoefficients &in_coeffs)
+    {
+      int y = ((in_y - 16) * 8 * in_coeffs.y) >> 16;
+      int u = (in_u - 128) * 8;
+      int v = (in_v - 128) * 8;
+      int r = y + ((v * in_coeffs.r_v) >> 16);
+      int g = y - ((u * in_coeffs.g_u) >> 16) - ((v * in_coeffs.g_v) >> 16);
+      int b = y + ((u * in_coeffs.b_u) >> 16);
+      r = r < 0 ? 0 : (r > 255 ? 255 : r);
+      g = g < 0 ? 0 : (g > 255 ? 255 : g);
+      b = b < 0 ? 0 : (b > 255 ? 255 : b);
+      return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+#ifdef SHL_IMAGE_USE_SSE2
+    // -------------------------------------------------------------------------
+    // yuv_to_rgb24_x8
+    // -------------------------------------------------------------------------
+    // Converts 8 pixels. in_y, in_u and in_v hold the 16bit samples (the
+    // chroma samples are already duplicated for each pixel)
+    //
+    static void yuv_to_rgb24_x8(__m128i in_y, __m128i in_u, __m128i in_v,
+                                const YUVCoefficients &in_coeffs, uint32_t *out_dst)
+    {
+      // (x * 8) * c >> 16 == x * c >> 13 (Q13 coefficients)
+      __m128i y = _mm_slli_epi16(_mm_sub_epi16(in_y, _mm_set1_epi16(16)), 3);
+      __m128i u = _mm_slli_epi16(_mm_sub_epi16(in_u, _mm_set1_epi16(128)), 3);
+      __m128i v = _mm_slli_epi16(_mm_sub_epi16(in_v, _mm_set1_epi16(128)), 3);
+      y = _mm_mulhi_epi16(y, _mm_set1_epi16(in_coeffs.y));
+      __m128i r = _mm_add_epi16(y, _mm_mulhi_epi16(v, _mm_set1_epi16(in_coeffs.r_v)));
+      __m128i g = _mm_sub_epi16(
+              _mm_sub_epi16(y, _mm_mulhi_epi16(u, _mm_set1_epi16(in_coeffs.g_u))),
+              _mm_mulhi_epi16(v, _mm_set1_epi16(in_coeffs.g_v)));
+      __m128i b = _mm_add_epi16(y, _mm_mulhi_epi16(u, _mm_set1_epi16(in_coeffs.b_u)));
+      // Saturates to [0, 255] and interleaves B, G, R, 0xFF
+      r = _mm_packus_epi16(r, r);
+      g = _mm_packus_epi16(g, g);
+      b = _mm_packus_epi16(b, b);
+      __m128i bg = _mm_unpacklo_epi8(b, g);
+      __m128i ra = _mm_unpacklo_epi8(r, _mm_set1_epi8((char )0xFF));
+      _mm_storeu_si128((__m128i *)out_dst, _mm_unpacklo_epi16(bg, ra));
+      _mm_storeu_si128((__m128i *)(out_dst + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+#endif
+  };
+
+  // ===========================================================================
+  //  BufferPool class - aligned image buffer pool
+  // ===========================================================================
+  class BufferPool
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    static constexpr size_t DEFAULT_MAX_CACHED_SIZE = 256 * 1024 * 1024;
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // get_pool
+    // -------------------------------------------------------------------------
+    // The pool is never destroyed, so that the Data objects with the static
+    // storage duration can return their buffers at any time
+    //
+    static BufferPool *get_pool()
+    {
+      static auto *s_pool = new BufferPool();
+      return s_pool;
+    }
+    // -------------------------------------------------------------------------
+    // get_size_class
+    // -------------------------------------------------------------------------
+    // 64 bytes steps up to 4KB, then 4 classes for each power of two
+    // (the overhead of the rounding is less than 25%)
+    //
+    static size_t get_size_class(size_t in_size)
+    {
+      if (in_size <= 4096)
+        return (in_size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+      size_t step = 1;
+      while (step <= in_size / 2)
+        step <<= 1;
+      step /= 4;
+      return (in_size + step - 1) & ~(step - 1);
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // acquire
+    // -------------------------------------------------------------------------
+    // Returns a 64 bytes aligned block of at least in_size bytes. The cached
+    // block of the same size class is reused if available
+    //
+    uint8_t *acquire(size_t in_size)
+    {
+      if (in_size == 0)
+        return nullptr;
+      size_t size = get_size_class(in_size);
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_free_blocks.find(size);
+      if (it != m_free_blocks.end())
+      {
+        uint8_t *ptr = it->second;
+        m_free_blocks.erase(it);
+        m_cached_size -= size;
+        m_used_blocks[ptr] = size;
+        return ptr;
+      }
+      size_t alignment = ALIGNMENT;
+      if (m_huge_page_enabled && size >= HUGE_PAGE_SIZE)
+        alignment = HUGE_PAGE_SIZE;
+      void *ptr = nullptr;
+      if (posix_memalign(&ptr, alignment, size) != 0)
+        return nullptr;
+#ifdef MADV_HUGEPAGE
+      if (alignment == HUGE_PAGE_SIZE)
+        madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+      m_used_blocks[(uint8_t *)ptr] = size;
+      return (uint8_t *)ptr;
+    }
+    // -------------------------------------------------------------------------
+    // release
+    // -------------------------------------------------------------------------
+    // Returns the block to the pool. The block is freed when the pool already
+    // caches more than the max cached size
+    //
+    void release(uint8_t *in_ptr)
+    {
+      if (in_ptr == nullptr)
+        return;
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto it = m_used_blocks.find(in_ptr);
+      if (it == m_used_blocks.end())
+        return;
+      size_t size = it->second;
+      m_used_blocks.erase(it);
+      if (m_cached_size + size > m_max_cached_size)
+      {
+        free(in_ptr);
+        return;
+      }
+      m_free_blocks.emplace(size, in_ptr);
+      m_cached_size += size;
+    }
+    // -------------------------------------------------------------------------
+    // trim
+    // -------------------------------------------------------------------------
+    // Frees all the cached (not used) blocks
+    //
+    void trim()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (auto &block : m_free_blocks)
+        free(block.second);
+      m_free_blocks.clear();
+      m_cached_size = 0;
+    }
+    // -------------------------------------------------------------------------
+    // get_cached_size
+    // -------------------------------------------------------------------------
+    size_t get_cached_size()
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_cached_size;
+    }
+    // -------------------------------------------------------------------------
+    // set_max_cached_size
+    // -------------------------------------------------------------------------
+    void set_max_cached_size(size_t in_size)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_max_cached_size = in_size;
+        if (m_cached_size <= m_max_cached_size)
+          return;
+      }
+      trim();
+    }
+    // -------------------------------------------------------------------------
+    // set_huge_page_enabled
+    // -------------------------------------------------------------------------
+    // The blocks larger than 2MB are aligned to the huge page boundary and
+    // advised to use the transparent huge pages (Linux)
+    //
+    void set_huge_page_enabled(bool in_enable)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_huge_page_enabled = in_enable;
+    }
+
+  protected:
+    // -------------------------------------------------------------------------
+    // BufferPool constructor
+    // -------------------------------------------------------------------------
+    BufferPool() :
+      m_cached_size(0),
+      m_max_cached_size(DEFAULT_MAX_CACHED_SIZE),
+      m_huge_page_enabled(false)
+    {
+    }
+
+  private:
+    // member variables --------------------------------------------------------
+    std::mutex m_mutex;
+    std::multimap<size_t, uint8_t *> m_free_blocks;
+    std::unordered_map<uint8_t *, size_t> m_used_blocks;
+    size_t m_cached_size;
+    size_t m_max_cached_size;
+    bool m_huge_page_enabled;
+  };
+
+  // ===========================================================================
+  //  Data class
+  // ===========================================================================
+  class Data
+  {
+  public:
+    // Constants ---------------------------------------------------------------
+    enum PixelFormat
+    {
+      PIXEL_FORMAT_NOT_SPECIFIED = 0,
+      PIXEL_FORMAT_MONO8,
+      PIXEL_FORMAT_RGB8,
+      PIXEL_FORMAT_MONO16,
+      PIXEL_FORMAT_MONO32F,
+      PIXEL_FORMAT_BGRA8,
+      PIXEL_FORMAT_RGBA8,
+      PIXEL_FORMAT_BGR8,
+      PIXEL_FORMAT_BAYER_RG8,
+      PIXEL_FORMAT_BAYER_GB8,
+      PIXEL_FORMAT_BAYER_GR8,
+      PIXEL_FORMAT_BAYER_BG8,
+      PIXEL_FORMAT_YUYV,
+      PIXEL_FORMAT_UYVY,
+      PIXEL_FORMAT_NV12,
+      PIXEL_FORMAT_I420
+    };
+    enum DemosaicMode
+    {
+      DEMOSAIC_BILINEAR = 0,
+      DEMOSAIC_NEAREST
+    };
+    enum YUVMatrix
+    {
+      YUV_MATRIX_BT601 = 0,
+      YUV_MATRIX_BT709
+    };
+    static constexpr int MAX_PLANE_NUM = 3;
+    static constexpr int TRIPLE_BUFFER_NUM = 3;
+    static constexpr int MAX_MODIFIED_REGION_NUM = 16;
+
+    // Types -------------------------------------------------------------------
+    struct Region
+    {
+      int x;
+      int y;
+      int width;
+      int height;
+    };
+
+    // -------------------------------------------------------------------------
+    // Data destructor
+    // -------------------------------------------------------------------------
+    virtual ~Data()
+    {
+      BufferPool::get_pool()->release(m_allocated_buffer_ptr);
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // allocate
+    // -------------------------------------------------------------------------
+    /**
+     * Allocates the image buffer internally.
+     *
+     * @param in_width      The width of the image buffer
+     * @param in_height     The height of the image
+     * @param in_is_mono    The type of the image
+     *  - true : Allocates the image buffer for the monochrome image (8bit x 1ch = MONO8)
+     *  - false : Allocates the image buffer for the color image (8bit x 3ch = RGB8)
+     * @return  The result of the function call
+     *  - true : The allocation was successful
+     *  - false : The allocation was failed
+     */
+    bool allocate(int in_width, int in_height, bool in_is_mono = false)
+    {
+      if (in_is_mono)
+        return allocate(in_width, in_height, PIXEL_FORMAT_MONO8);
+      return allocate(in_width, in_height, PIXEL_FORMAT_RGB8);
+    }
+    // -------------------------------------------------------------------------
+    // allocate
+    // -------------------------------------------------------------------------
+    /**
+     * Allocates the image buffer internally. The buffer is 64 bytes aligned
+     * and taken from the BufferPool, so re-allocating a recently used size is
+     * cheap. When the geometry and the format are unchanged, the current
+     * buffer is kept as is (including its contents).
+     *
+     * @param in_width      The width of the image buffer (needs to be even for the YUV formats)
+     * @param in_height     The height of the image
+     * @param in_format     The pixel format of the image (e.g. PIXEL_FORMAT_MONO16)
+     * @return  The result of the function call
+     *  - true : The allocation was successful
+     *  - false : The allocation was failed
+     */
+    bool allocate(int in_width, int in_height, PixelFormat in_format)
+    {
+      return allocate_slots(in_width, in_height, in_format, 1);
+    }
+    // -------------------------------------------------------------------------
+    // allocate_triple_buffer
+    // -------------------------------------------------------------------------
+    /**
+     * Allocates three image buffers internally and enables the triple buffer
+     * mode. In this mode, a producer thread writes the frame into the back
+     * buffer (get_back_buffer()) and publishes it by calling
+     * publish_back_buffer(). The view always displays the latest published
+     * frame and neither of the threads waits for the other.
+     * @note get_image() returns the buffer owned by the view (the front
+     * buffer) in this mode. The producer needs to use get_back_buffer().
+     * @note This function needs to be called while no producer is writing
+     * the image buffer. Calling allocate() or set_external_buffer() disables
+     * the triple buffer mode.
+     *
+     * @param in_width      The width of the image buffer (needs to be even for the YUV formats)
+     * @param in_height     The height of the image
+     * @param in_format     The pixel format of the image (e.g. PIXEL_FORMAT_MONO16)
+     * @return  The result of the function call
+     *  - true : The allocation was successful
+     *  - false : The allocation was failed
+     */
+    bool allocate_triple_buffer(int in_width, int in_height, PixelFormat in_format)
+    {
+      return allocate_slots(in_width, in_height, in_format, TRIPLE_BUFFER_NUM);
+    }
+    // -------------------------------------------------------------------------
+    // is_triple_buffer_enabled
+    // -------------------------------------------------------------------------
+    /**
+     * Checks whether the triple buffer mode is enabled or not.
+     *
+     * @return
+     *  - true : The triple buffer mode is enabled (allocate_triple_buffer())
+     *  - false : The single image buffer is used
+     */
+    [[nodiscard]] bool is_triple_buffer_enabled() const
+    {
+      return m_slot_num == TRIPLE_BUFFER_NUM;
+    }
+    // -------------------------------------------------------------------------
+    // get_back_buffer
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the buffer the producer can write the next frame into.
+     * The layout of the buffer is the same as get_image() (the chroma planes
+     * of the planar formats follow the Y plane). The buffer is owned by the
+     * producer until publish_back_buffer() is called.
+     *
+     * @return The pointer for the back buffer (nullptr if the triple buffer
+     * mode is not enabled)
+     */
+    [[nodiscard]] uint8_t *get_back_buffer() const
+    {
+      if (is_triple_buffer_enabled() == false)
+        return nullptr;
+      return get_slot(m_back_slot);
+    }
+    // -------------------------------------------------------------------------
+    // publish_back_buffer
+    // -------------------------------------------------------------------------
+    /**
+     * Publishes the frame written into the back buffer as the latest frame
+     * and hands a new back buffer to the producer. This function never
+     * blocks. The previously published frame is dropped if the view has not
+     * picked it up yet.
+     * @note Only one producer thread can call this function at a time.
+     * get_back_buffer() needs to be called again after this call.
+     *
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will increment the frame counter
+     * @return  The result of the function call
+     *  - true : The frame was published
+     *  - false : The triple buffer mode is not enabled
+     */
+    bool publish_back_buffer(bool in_skip_frame_counter_update = false)
+    {
+      if (is_triple_buffer_enabled() == false)
+        return false;
+      m_slot_frame_counter[m_back_slot] = m_published_frame_counter;
+      if (in_skip_frame_counter_update == false)
+      {
+        m_published_frame_counter++;
+        m_produced_frame_num.fetch_add(1, std::memory_order_release);
+      }
+      unsigned int prev = m_latest_slot.exchange(m_back_slot | LATEST_SLOT_FRESH,
+                                                 std::memory_order_acq_rel);
+      m_back_slot = prev & LATEST_SLOT_INDEX_MASK;
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // set_external_buffer
+    // -------------------------------------------------------------------------
+    /**
+     * Specifies the external image buffer.
+     *
+     * @param in_buffer_ptr     The pointer for the external image buffer
+     * @param in_width          The height of the image
+     * @param in_height         The height of the image
+     * @param in_is_mono        The type of the image
+     *  - true : Allocates the image buffer for the monochrome image (8bit x 1ch = MONO8)
+     *  - false : Allocates the image buffer for the color image (8bit x 3ch = RGB8)
+     * @param in_skip_frame_counter_update
+     *  - true : Skips incrementing the frame counter. The frame counter will be unchanged.
+     *  - false : The frame counter will be incremented (updated).
+     * @return  The result of the function call
+     *  - true : Changing the image buffer was successful
+     *  - false : An error has occurred. The parameter specified was wrong.
+     */
+    bool set_external_buffer(uint8_t *in_buffer_ptr, int in_width, int in_height, bool in_is_mono = false,
+                             bool in_skip_frame_counter_update = false)
+    {
+      if (in_is_mono)
+        return set_external_buffer(in_buffer_ptr, in_width, in_height,
+                                   PIXEL_FORMAT_MONO8, 0, in_skip_frame_counter_update);
+      return set_external_buffer(in_buffer_ptr, in_width, in_height,
+                                 PIXEL_FORMAT_RGB8, 0, in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // set_external_buffer
+    // -------------------------------------------------------------------------
+    /**
+     * Specifies the external image buffer.
+     *
+     * @param in_buffer_ptr     The pointer for the external image buffer
+     * @param in_width          The height of the image
+     * @param in_height         The height of the image
+     * @param in_format         The pixel format of the image (e.g. PIXEL_FORMAT_MONO16)
+     * @param in_stride         The distance between the rows in bytes
+     *                          (0 means the rows are tightly packed)
+     * @param in_skip_frame_counter_update
+     *  - true : Skips incrementing the frame counter. The frame counter will be unchanged.
+     *  - false : The frame counter will be incremented (updated).
+     * @return  The result of the function call
+     *  - true : Changing the image buffer was successful
+     *  - false : An error has occurred. The parameter specified was wrong.
+     * @note A BGRA8 buffer whose stride is a multiple of 4 is drawn directly
+     * (without copying) on little endian machines, so the buffer needs to be
+     * kept valid while it is set to the object.
+     * @note For NV12 and I420, the chroma planes need to follow the Y plane
+     * in the buffer (the stride of the I420 chroma planes is in_stride / 2).
+     * Use set_external_planes() for the separated planes.
+     */
+    bool set_external_buffer(uint8_t *in_buffer_ptr, int in_width, int in_height,
+                             PixelFormat in_format, size_t in_stride = 0,
+                             bool in_skip_frame_counter_update = false)
+    {
+      size_t packed_stride = (size_t )in_width * get_bytes_per_pixel(in_format);
+      if (in_stride == 0)
+        in_stride = packed_stride;
+      if (in_buffer_ptr == nullptr || in_width == 0 || in_height == 0 ||
+          packed_stride == 0 || in_stride < packed_stride ||
+          is_valid_width(in_format, in_width) == false)
+      {
+        cleanup_buffers();
+        return false;
+      }
+      //
+      if (m_allocated_buffer_ptr != nullptr)
+      {
+        BufferPool::get_pool()->release(m_allocated_buffer_ptr);
+        m_allocated_buffer_ptr = nullptr;
+      }
+      reset_slots(1);
+      release_submitted_buffers();
+      m_external_buffer_ptr = in_buffer_ptr;
+      m_width = in_width;
+      m_height = in_height;
+      m_pixel_format = in_format;
+      m_stride = in_stride;
+      update_planes(in_buffer_ptr);
+      update_image_buffer_size();
+      mark_as_modified(in_skip_frame_counter_update);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // submit_buffer
+    // -------------------------------------------------------------------------
+    /**
+     * Submits an image buffer owned by the caller (e.g. a driver ring buffer)
+     * for display without copying. The object keeps a reference of the buffer
+     * while the view needs it and drops it when the view has switched to a
+     * newer buffer. The buffer is returned to the owner by the deleter of
+     * in_buffer (see the overload with the release function).
+     * This function can be called from a producer thread and never waits
+     * for the UI thread. When a submitted buffer is replaced before being
+     * displayed, it is released immediately (counted as a dropped frame).
+     * @note At most two submitted buffers are held at a time (the displayed
+     * one and the one waiting to be displayed).
+     *
+     * @param in_buffer         The image buffer
+     * @param in_width          The width of the image
+     * @param in_height         The height of the image
+     * @param in_format         The pixel format of the image (e.g. PIXEL_FORMAT_MONO16)
+     * @param in_stride         The distance between the rows in bytes
+     *                          (0 means the rows are tightly packed)
+     * @param in_skip_frame_counter_update
+     *  - true : Skips incrementing the frame counter. The frame counter will be unchanged.
+     *  - false : The frame counter will be incremented (updated).
+     * @return  The result of the function call
+     *  - true : The buffer was submitted
+     *  - false : An error has occurred. The parameter specified was wrong
+     *    (the buffer is released immediately).
+     */
+    bool submit_buffer(std::shared_ptr<uint8_t> in_buffer, int in_width, int in_height,
+                       PixelFormat in_format, size_t in_stride = 0,
+                       bool in_skip_frame_counter_update = false)
+    {
+      size_t packed_stride = (size_t )in_width * get_bytes_per_pixel(in_format);
+      if (in_stride == 0)
+        in_stride = packed_stride;
+      if (!in_buffer || in_width <= 0 || in_height <= 0 ||
+          packed_stride == 0 || in_stride < packed_stride ||
+          is_valid_width(in_format, in_width) == false)
+        return false;
+      // The replaced pending buffer is released after unlocking
+      std::shared_ptr<uint8_t> dropped_buffer;
+      {
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        dropped_buffer = std::move(m_pending_submission.buffer);
+        m_pending_submission.buffer = std::move(in_buffer);
+        m_pending_submission.width = in_width;
+        m_pending_submission.height = in_height;
+        m_pending_submission.format = in_format;
+        m_pending_submission.stride = in_stride;
+        m_pending_submission.frame_counter = m_submitted_frame_counter;
+        if (in_skip_frame_counter_update == false)
+          m_submitted_frame_counter++;
+      }
+      if (in_skip_frame_counter_update == false)
+        m_produced_frame_num.fetch_add(1, std::memory_order_release);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // submit_buffer
+    // -------------------------------------------------------------------------
+    /**
+     * Submits an image buffer owned by the caller with the release function.
+     * in_release_func is called exactly once with in_buffer_ptr when the
+     * buffer is not needed anymore (it can be called from the UI thread or
+     * from the thread calling this function).
+     *
+     * @param in_buffer_ptr     The pointer for the image buffer
+     * @param in_width          The width of the image
+     * @param in_height         The height of the image
+     * @param in_format         The pixel format of the image (e.g. PIXEL_FORMAT_MONO16)
+     * @param in_stride         The distance between the rows in bytes
+     *                          (0 means the rows are tightly packed)
+     * @param in_release_func   The function returning the buffer to the owner
+     * @param in_skip_frame_counter_update
+     *  - true : Skips incrementing the frame counter. The frame counter will be unchanged.
+     *  - false : The frame counter will be incremented (updated).
+     * @return  The result of the function call
+     *  - true : The buffer was submitted
+     *  - false : An error has occurred. The parameter specified was wrong
+     *    (in_release_func is called before returning, except when
+     *    in_buffer_ptr is nullptr since there is nothing to release).
+     */
+    bool submit_buffer(uint8_t *in_buffer_ptr, int in_width, int in_height,
+                       PixelFormat in_format, size_t in_stride,
+                       const std::function<void(uint8_t *)> &in_release_func,
+                       bool in_skip_frame_counter_update = false)
+    {
+      if (in_buffer_ptr == nullptr)
+        return false;
+      std::shared_ptr<uint8_t> buffer(in_buffer_ptr,
+                                      [in_release_func](uint8_t *in_ptr)
+                                      {
+                                        if (in_release_func)
+                                          in_release_func(in_ptr);
+                                      });
+      return submit_buffer(std::move(buffer), in_width, in_height, in_format, in_stride,
+                           in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // set_external_planes
+    // -------------------------------------------------------------------------
+    /**
+     * Specifies the external image buffer of a planar format whose planes are
+     * not contiguous (e.g. the planes of a V4L2 multi-planar buffer).
+     *
+     * @param in_width          The width of the image
+     * @param in_height         The height of the image
+     * @param in_format         The pixel format of the image (PIXEL_FORMAT_NV12 or PIXEL_FORMAT_I420)
+     * @param in_plane0         The pointer for the Y plane
+     * @param in_stride0        The stride of the Y plane (0 means tightly packed)
+     * @param in_plane1         The pointer for the UV plane (NV12) or the U plane (I420)
+     * @param in_stride1        The stride of the plane 1 (0 means tightly packed)
+     * @param in_plane2         The pointer for the V plane (I420 only)
+     * @param in_stride2        The stride of the plane 2 (0 means tightly packed)
+     * @param in_skip_frame_counter_update
+     *  - true : Skips incrementing the frame counter. The frame counter will be unchanged.
+     *  - false : The frame counter will be incremented (updated).
+     * @return  The result of the function call
+     *  - true : Changing the image buffer was successful
+     *  - false : An error has occurred. The parameter specified was wrong.
+     */
+    bool set_external_planes(int in_width, int in_height, PixelFormat in_format,
+                             uint8_t *in_plane0, size_t in_stride0,
+                             uint8_t *in_plane1, size_t in_stride1,
+                             uint8_t *in_plane2 = nullptr, size_t in_stride2 = 0,
+                             bool in_skip_frame_counter_update = false)
+    {
+      uint8_t *planes[MAX_PLANE_NUM] = {in_plane0, in_plane1, in_plane2};
+      size_t strides[MAX_PLANE_NUM] = {in_stride0, in_stride1, in_stride2};
+      int plane_num = get_plane_num(in_format);
+      if (plane_num < 2 || in_width == 0 || in_height == 0 ||
+          is_valid_width(in_format, in_width) == false)
+      {
+        cleanup_buffers();
+        return false;
+      }
+      for (int i = 0; i < plane_num; i++)
+      {
+        size_t packed_stride = get_plane_packed_stride(in_format, in_width, i);
+        if (strides[i] == 0)
+          strides[i] = packed_stride;
+        if (planes[i] == nullptr || strides[i] < packed_stride)
+        {
+          cleanup_buffers();
+          return false;
+        }
+      }
+      //
+      if (m_allocated_buffer_ptr != nullptr)
+      {
+        BufferPool::get_pool()->release(m_allocated_buffer_ptr);
+        m_allocated_buffer_ptr = nullptr;
+      }
+      reset_slots(1);
+      release_submitted_buffers();
+      m_external_buffer_ptr = planes[0];
+      m_width = in_width;
+      m_height = in_height;
+      m_pixel_format = in_format;
+      m_stride = strides[0];
+      for (int i = 1; i < MAX_PLANE_NUM; i++)
+      {
+        m_plane_ptr[i] = (i < plane_num) ? planes[i] : nullptr;
+        m_plane_stride[i] = (i < plane_num) ? strides[i] : 0;
+      }
+      update_image_buffer_size();
+      mark_as_modified(in_skip_frame_counter_update);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // get_image
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the pointer for the image buffer.
+     * @note The image buffer needs to be allocated beforehand.
+     *
+     * @return The pointer for the image buffer
+     */
+    [[nodiscard]] uint8_t *get_image() const
+    {
+      if (m_allocated_buffer_ptr != nullptr)
+        return get_slot(m_front_slot);
+      return m_external_buffer_ptr;
+    }
+    // -------------------------------------------------------------------------
+    // get_plane
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the pointer for the plane of the image buffer.
+     * The plane 0 is the same as get_image(). The plane 1 and 2 are valid only
+     * for the planar formats (NV12: UV, I420: U and V).
+     *
+     * @param in_index  The index of the plane
+     * @return The pointer for the plane (nullptr if the plane does not exist)
+     */
+    [[nodiscard]] uint8_t *get_plane(int in_index) const
+    {
+      if (in_index == 0)
+        return get_image();
+      if (in_index < 0 || in_index >= get_plane_num(m_pixel_format))
+        return nullptr;
+      return m_plane_ptr[in_index];
+    }
+    // -------------------------------------------------------------------------
+    // get_plane_stride
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the distance between the rows of the plane.
+     *
+     * @param in_index  The index of the plane
+     * @return The stride of the plane (bytes)
+     */
+    [[nodiscard]] size_t get_plane_stride(int in_index) const
+    {
+      if (in_index == 0)
+        return m_stride;
+      if (in_index < 0 || in_index >= get_plane_num(m_pixel_format))
+        return 0;
+      return m_plane_stride[in_index];
+    }
+    // -------------------------------------------------------------------------
+    // get_plane_height
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the number of the rows of the plane.
+     *
+     * @param in_index  The index of the plane
+     * @return The number of the rows (0 if the plane does not exist)
+     */
+    [[nodiscard]] int get_plane_height(int in_index) const
+    {
+      if (in_index < 0 || in_index >= get_plane_num(m_pixel_format))
+        return 0;
+      if (in_index == 0)
+        return m_height;
+      return (m_height + 1) / 2;
+    }
+    // -------------------------------------------------------------------------
+    // get_pixel_value
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the pixel value of the image buffer.
+     * @note The image buffer needs to be allocated beforehand.
+     *
+     * @param in_x          The x position of the pixel
+     * @param in_y          The y position of the pixel
+     * @param out_is_mono   The type of the image
+     *  - true : The image is monochrome (MONO8, MONO16 or MONO32F)
+     *  - false : The image is color (RGB8, BGR8, BGRA8 or RGBA8)
+     * @param out_r         The pixel value of the specified location (The r component or monochrome pixel value)
+     * @param out_g         The pixel value of the specified location (The g component of the pixel value)
+     * @param out_b         The pixel value of the specified location (The b component of the pixel value)
+     * @return  The result of the function call
+     *  - true : Changing the image buffer was successful
+     *  - false : An error has occurred. The parameter specified was wrong.
+     */
+    virtual bool get_pixel_value(int in_x, int in_y,
+                         bool *out_is_mono, int *out_r, int *out_g, int *out_b)
+    {
+      double r, g, b;
+      if (get_pixel_value_double(in_x, in_y, out_is_mono, &r, &g, &b) == false)
+        return false;
+      *out_r = to_pixel_int(r);
+      *out_g = to_pixel_int(g);
+      *out_b = to_pixel_int(b);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // get_pixel_value_double
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the pixel value of the image buffer without truncation.
+     * @note The floating point formats (MONO32F) are reported as is (NaN and
+     * Inf included). get_pixel_value() truncates them and saturates the
+     * values outside of the int range (NaN is reported as 0).
+     * The YUV formats report the Y, U and V values in out_r, out_g and out_b.
+     *
+     * @param in_x          The x position of the pixel
+     * @param in_y          The y position of the pixel
+     * @param out_is_mono   The type of the image
+     * @param out_r         The r component or monochrome pixel value
+     * @param out_g         The g component of the pixel value
+     * @param out_b         The b component of the pixel value
+     * @return  The result of the function call
+     *  - true : Retrieving the pixel value was successful
+     *  - false : An error has occurred. The parameter specified was wrong.
+     */
+    bool get_pixel_value_double(int in_x, int in_y,
+                                bool *out_is_mono, double *out_r, double *out_g, double *out_b) const
+    {
+      if (is_valid() == false)
+        return false;
+      if (in_x < 0 || in_x >= get_width() ||
+          in_y < 0 || in_y >= get_height())
+        return false;
+      //
+      *out_is_mono = is_mono();
+      unsigned char *pixBuf = get_image() + (size_t )in_y * m_stride;
+      size_t index = in_x;
+      switch (m_pixel_format)
+      {
+        case PIXEL_FORMAT_MONO8:
+          *out_r = pixBuf[index];
+          *out_g = 0;
+          *out_b = 0;
+          break;
+        case PIXEL_FORMAT_MONO16:
+          *out_r = ((const uint16_t *)pixBuf)[index];
+          *out_g = 0;
+          *out_b = 0;
+          break;
+        case PIXEL_FORMAT_MONO32F:
+          *out_r = ((const float *)pixBuf)[index];
+          *out_g = 0;
+          *out_b = 0;
+          break;
+        case PIXEL_FORMAT_RGB8:
+          index *= 3;
+          *out_r = pixBuf[index];
+          *out_g = pixBuf[index+1];
+          *out_b = pixBuf[index+2];
+          break;
+        case PIXEL_FORMAT_BGRA8:
+          index *= 4;
+          *out_r = pixBuf[index+2];
+          *out_g = pixBuf[index+1];
+          *out_b = pixBuf[index];
+          break;
+        case PIXEL_FORMAT_RGBA8:
+          index *= 4;
+          *out_r = pixBuf[index];
+          *out_g = pixBuf[index+1];
+          *out_b = pixBuf[index+2];
+          break;
+        case PIXEL_FORMAT_BGR8:
+          index *= 3;
+          *out_r = pixBuf[index+2];
+          *out_g = pixBuf[index+1];
+          *out_b = pixBuf[index];
+          break;
+        case PIXEL_FORMAT_BAYER_RG8:
+        case PIXEL_FORMAT_BAYER_GB8:
+        case PIXEL_FORMAT_BAYER_GR8:
+        case PIXEL_FORMAT_BAYER_BG8:
+          // Reports the raw sensor value
+          *out_is_mono = true;
+          *out_r = pixBuf[index];
+          *out_g = 0;
+          *out_b = 0;
+          break;
+        case PIXEL_FORMAT_YUYV:
+        case PIXEL_FORMAT_UYVY:
+        case PIXEL_FORMAT_NV12:
+        case PIXEL_FORMAT_I420:
+          // Reports the Y, U and V values
+          get_yuv_value(in_x, in_y, out_r, out_g, out_b);
+          break;
+        default:
+          return false;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // mark_as_modified
+    // -------------------------------------------------------------------------
+    /**
+     * Marks the image buffer as modified. Once the modified flag of the image
+     * is set by calling this function and if there is a window displaying
+     * the image buffer, the window will be redrawed to display the updated
+     * image buffer.
+     *
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void mark_as_modified(bool in_skip_frame_counter_update = false)
+    {
+      mark_whole_image_modified();
+      if (in_skip_frame_counter_update == false)
+      {
+        increment_frame_counter();
+        m_produced_frame_num.fetch_add(1, std::memory_order_release);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // is_modified
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the modified flag of the image buffer
+     *
+     * @return  The state of the modified flag
+     *  - true : The image buffer is marked as modified
+     *  - false : The image buffer is not marked as modified
+     */
+    [[nodiscard]] bool is_modified() const
+    {
+      return m_is_image_modified.load(std::memory_order_acquire);
+    }
+    // -------------------------------------------------------------------------
+    // mark_region_modified
+    // -------------------------------------------------------------------------
+    /**
+     * Marks a region of the image buffer as modified. The regions are
+     * accumulated until the window displays the image, and only the marked
+     * regions are converted and redrawn (e.g. the rows appended by a line
+     * scan camera or the overlay updated in a small ROI). The overlapping or
+     * adjacent regions are merged, and too many regions are merged into
+     * their bounding box. mark_as_modified() overrides the regions.
+     *
+     * @param in_x       The left of the region
+     * @param in_y       The top of the region
+     * @param in_width   The width of the region
+     * @param in_height  The height of the region
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void mark_region_modified(int in_x, int in_y, int in_width, int in_height,
+                              bool in_skip_frame_counter_update = false)
+    {
+      int x0 = std::max(in_x, 0);
+      int y0 = std::max(in_y, 0);
+      int x1 = std::min(in_x + in_width, m_width);
+      int y1 = std::min(in_y + in_height, m_height);
+      if (x0 >= x1 || y0 >= y1)
+        return;
+      {
+        std::lock_guard<std::mutex> lock(m_modified_region_mutex);
+        if (m_is_whole_image_modified == false)
+          add_modified_region(x0, y0, x1, y1);
+        m_is_image_modified.store(true, std::memory_order_release);
+      }
+      if (in_skip_frame_counter_update == false)
+      {
+        increment_frame_counter();
+        m_produced_frame_num.fetch_add(1, std::memory_order_release);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // is_partially_modified
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves whether only the regions marked by mark_region_modified() are
+     * modified
+     *
+     * @return
+     *  - true : Only the marked regions are modified
+     *  - false : The whole image is modified or the image is not modified
+     */
+    [[nodiscard]] bool is_partially_modified()
+    {
+      std::lock_guard<std::mutex> lock(m_modified_region_mutex);
+      return (m_is_whole_image_modified == false && m_modified_regions.empty() == false);
+    }
+    // -------------------------------------------------------------------------
+    // get_modified_regions
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the regions marked by mark_region_modified() since the last
+     * display of the image
+     *
+     * @param out_regions  The modified regions
+     *
+     * @return
+     *  - true : Only the regions in out_regions are modified
+     *  - false : The whole image is modified (out_regions is empty)
+     */
+    bool get_modified_regions(std::vector<Region> *out_regions)
+    {
+      std::lock_guard<std::mutex> lock(m_modified_region_mutex);
+      *out_regions = m_modified_regions;
+      return (m_is_whole_image_modified == false);
+    }
+    // -------------------------------------------------------------------------
+    // clear_modified_flag
+    // -------------------------------------------------------------------------
+    /**
+     * Clears the modified flag of the image buffer.
+     */
+    void clear_modified_flag()
+    {
+      std::lock_guard<std::mutex> lock(m_modified_region_mutex);
+      m_is_image_modified.store(false, std::memory_order_release);
+      m_is_whole_image_modified = false;
+      m_modified_regions.clear();
+    }
+    // -------------------------------------------------------------------------
+    // set_frame_counter
+    // -------------------------------------------------------------------------
+    /**
+     * Sets the frame counter of the image buffer.
+     *
+     * @param in_frame_counter  The new frame counter value
+     */
+    void set_frame_counter(unsigned int in_frame_counter)
+    {
+      m_frame_counter_initialized = true;
+      m_frame_counter = in_frame_counter;
+    }
+    // -------------------------------------------------------------------------
+    // get_frame_counter
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the frame counter of the image buffer.
+     *
+     * @return  The frame counter value of the image buffer
+     */
+    [[nodiscard]] unsigned int get_frame_counter() const
+    {
+      if (m_frame_counter_initialized == false)
+        return 0;
+      return m_frame_counter;
+    }
+    // -------------------------------------------------------------------------
+    // increment_frame_counter
+    // -------------------------------------------------------------------------
+    /**
+     * Increments the frame counter of the image buffer.
+     */
+    void increment_frame_counter()
+    {
+      if (m_frame_counter_initialized == false)
+      {
+        m_frame_counter_initialized = true;
+        m_frame_counter = 0;
+        return;
+      }
+      m_frame_counter++;
+    }
+    // -------------------------------------------------------------------------
+    // reset_frame_counter
+    // -------------------------------------------------------------------------
+    /**
+     * Resets the frame counter to zero.
+     */
+    void reset_frame_counter()
+    {
+      m_frame_counter_initialized = false;
+      m_frame_counter = 0;
+    }
+    // -------------------------------------------------------------------------
+    // get_produced_frame_num
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the number of the frames submitted by the producer
+     * (mark_as_modified() or publish_back_buffer() calls that update the
+     * frame counter). update() does not count a frame by itself, so the image
+     * written directly to the buffer needs mark_as_modified() to be counted.
+     *
+     * @return  The number of the produced frames
+     */
+    [[nodiscard]] uint64_t get_produced_frame_num() const
+    {
+      return m_produced_frame_num.load(std::memory_order_acquire);
+    }
+    // -------------------------------------------------------------------------
+    // get_displayed_frame_num
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the number of the produced frames that were displayed by
+     * the view.
+     *
+     * @return  The number of the displayed frames
+     */
+    [[nodiscard]] uint64_t get_displayed_frame_num() const
+    {
+      return m_displayed_frame_num.load(std::memory_order_acquire);
+    }
+    // -------------------------------------------------------------------------
+    // get_dropped_frame_num
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the number of the produced frames that were replaced by a
+     * newer frame before being displayed (including the frame waiting to be
+     * displayed).
+     *
+     * @return  The number of the dropped frames
+     */
+    [[nodiscard]] uint64_t get_dropped_frame_num() const
+    {
+      uint64_t displayed = get_displayed_frame_num();
+      uint64_t produced = get_produced_frame_num();
+      if (produced < displayed)
+        return 0;
+      return produced - displayed;
+    }
+    // -------------------------------------------------------------------------
+    // reset_frame_statistics
+    // -------------------------------------------------------------------------
+    /**
+     * Resets the produced and the displayed frame numbers to zero.
+     * @note This can be called from any thread.
+     */
+    void reset_frame_statistics()
+    {
+      m_produced_frame_num.store(0, std::memory_order_release);
+      m_displayed_frame_num.store(0, std::memory_order_release);
+      m_last_displayed_produced_num.store(0, std::memory_order_release);
+    }
+    // -------------------------------------------------------------------------
+    // get_colormap_index
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the colormap index of the image buffer. The colormap index
+     * is used only when the type of the image buffer is monochrome.
+     *
+     * @return  The colormap index of the image buffer
+     */
+    [[nodiscard]] Colormap::ColormapIndex get_colormap_index() const
+    {
+      return m_colormap_index;
+    }
+    // -------------------------------------------------------------------------
+    // set_colormap_index
+    // -------------------------------------------------------------------------
+    /**
+     * Set the colormap index of the image buffer. The colormap index
+     * is used only when the type of the image buffer is monochrome.
+     * @note The modified flag of the image buffer will bet set
+     * by calling this function.
+     *
+     * @param in_index  The new colormap index of the image buffer
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_colormap_index(Colormap::ColormapIndex in_index,
+                            bool in_skip_frame_counter_update = true)
+    {
+      if (m_colormap_index == in_index)
+        return;
+      m_colormap_index = in_index;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // get_window_level
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the window/level setting of the image buffer. The window/level
+     * is used only when the pixel format of the image buffer is MONO16.
+     *
+     * @param out_window    The width of the displayed value range
+     * @param out_level     The center of the displayed value range
+     */
+    void get_window_level(int *out_window, int *out_level) const
+    {
+      *out_window = m_window_level_window;
+      *out_level = m_window_level_level;
+    }
+    // -------------------------------------------------------------------------
+    // set_window_level
+    // -------------------------------------------------------------------------
+    /**
+     * Set the window/level of the image buffer. The pixel values in the range of
+     * [in_level - in_window / 2, in_level + in_window / 2) are mapped to the
+     * colormap and the values outside of the range are saturated.
+     * The window/level is used only when the pixel format of the image buffer
+     * is MONO16. (e.g. in_window = 4096, in_level = 2048 for 12bit images)
+     * @note The modified flag of the image buffer will bet set
+     * by calling this function.
+     *
+     * @param in_window     The width of the displayed value range (>= 1)
+     * @param in_level      The center of the displayed value range
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_window_level(int in_window, int in_level,
+                          bool in_skip_frame_counter_update = true)
+    {
+      if (in_window < 1)
+        in_window = 1;
+      if (m_window_level_window == in_window &&
+          m_window_level_level == in_level)
+        return;
+      m_window_level_window = in_window;
+      m_window_level_level = in_level;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // get_float_range
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the display range of the image buffer. The display range
+     * is used only when the pixel format of the image buffer is MONO32F.
+     *
+     * @param out_min       The value mapped to the first colormap entry
+     * @param out_max       The value mapped to the last colormap entry
+     * @return  The auto-range setting
+     *  - true : The range is calculated from each frame (out_min/max are not used)
+     *  - false : The range specified by set_float_range() is used
+     */
+    bool get_float_range(double *out_min, double *out_max) const
+    {
+      *out_min = m_float_range_min;
+      *out_max = m_float_range_max;
+      return m_float_auto_range;
+    }
+    // -------------------------------------------------------------------------
+    // set_float_range
+    // -------------------------------------------------------------------------
+    /**
+     * Set the display range of the image buffer and disables the auto-range.
+     * The display range is used only when the pixel format of the image
+     * buffer is MONO32F.
+     * @note The modified flag of the image buffer will bet set
+     * by calling this function.
+     *
+     * @param in_min        The value mapped to the first colormap entry
+     * @param in_max        The value mapped to the last colormap entry
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_float_range(double in_min, double in_max,
+                         bool in_skip_frame_counter_update = true)
+    {
+      m_float_auto_range = false;
+      m_float_range_min = in_min;
+      m_float_range_max = in_max;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // set_float_auto_range
+    // -------------------------------------------------------------------------
+    /**
+     * Enables or disables the auto-range of the MONO32F image buffer. When
+     * enabled, the range of the finite pixel values (NaN and Inf are skipped)
+     * is mapped to the colormap for each frame.
+     *
+     * @param in_enable     The auto-range setting
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_float_auto_range(bool in_enable,
+                              bool in_skip_frame_counter_update = true)
+    {
+      if (m_float_auto_range == in_enable)
+        return;
+      m_float_auto_range = in_enable;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // get_display_window_level
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the display window/level override of the monochrome image
+     * buffer.
+     *
+     * @param out_window    The width of the displayed value range
+     * @param out_level     The center of the displayed value range
+     * @return  The override setting
+     *  - true : The override is used (out_window/out_level are valid)
+     *  - false : The window/level or the display range of the pixel format is used
+     */
+    bool get_display_window_level(double *out_window, double *out_level) const
+    {
+      std::lock_guard<std::mutex> lock(m_display_window_level_mutex);
+      *out_window = m_display_window;
+      *out_level = m_display_level;
+      return m_is_display_window_level;
+    }
+    // -------------------------------------------------------------------------
+    // set_display_window_level
+    // -------------------------------------------------------------------------
+    /**
+     * Overrides the mapping of the monochrome image buffer (MONO8, MONO16 and
+     * MONO32F) to the colormap. The pixel values in the range of
+     * [in_level - in_window / 2, in_level + in_window / 2) are mapped to the
+     * colormap and the values outside of the range are saturated.
+     * The override takes precedence over set_window_level() and
+     * set_float_range(). The pixel values are not changed and the displayed
+     * frame is mapped again without a new frame.
+     * (The view sets this by dragging with the right mouse button)
+     * @note The modified flag of the image buffer will bet set
+     * by calling this function.
+     *
+     * @param in_window     The width of the displayed value range (> 0)
+     * @param in_level      The center of the displayed value range
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_display_window_level(double in_window, double in_level,
+                                  bool in_skip_frame_counter_update = true)
+    {
+      if (std::isfinite(in_window) == false || std::isfinite(in_level) == false)
+        return;
+      if (in_window < DBL_MIN)
+        in_window = DBL_MIN;
+      {
+        std::lock_guard<std::mutex> lock(m_display_window_level_mutex);
+        if (m_is_display_window_level &&
+            m_display_window == in_window && m_display_level == in_level)
+          return;
+        m_is_display_window_level = true;
+        m_display_window = in_window;
+        m_display_level = in_level;
+      }
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // reset_display_window_level
+    // -------------------------------------------------------------------------
+    /**
+     * Removes the display window/level override set by
+     * set_display_window_level().
+     * @note The modified flag of the image buffer will bet set
+     * by calling this function.
+     *
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void reset_display_window_level(bool in_skip_frame_counter_update = true)
+    {
+      {
+        std::lock_guard<std::mutex> lock(m_display_window_level_mutex);
+        if (m_is_display_window_level == false)
+          return;
+        m_is_display_window_level = false;
+      }
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // get_demosaic_mode
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the demosaic mode used to display the Bayer image buffer.
+     *
+     * @return  The demosaic mode of the image buffer
+     */
+    [[nodiscard]] DemosaicMode get_demosaic_mode() const
+    {
+      return m_demosaic_mode;
+    }
+    // -------------------------------------------------------------------------
+    // set_demosaic_mode
+    // -------------------------------------------------------------------------
+    /**
+     * Set the demosaic mode used to display the Bayer image buffer.
+     * The demosaic mode is used only when the pixel format of the image buffer
+     * is one of the PIXEL_FORMAT_BAYER_XX8 formats.
+     *
+     * @param in_mode       The demosaic mode
+     *  - DEMOSAIC_BILINEAR : Bilinear interpolation (default)
+     *  - DEMOSAIC_NEAREST : Uses the pixels of each 2x2 cell (fast preview)
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_demosaic_mode(DemosaicMode in_mode,
+                           bool in_skip_frame_counter_update = true)
+    {
+      if (m_demosaic_mode == in_mode)
+        return;
+      m_demosaic_mode = in_mode;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // set_async_conversion
+    // -------------------------------------------------------------------------
+    /**
+     * Enables or disables the asynchronous conversion. When enabled, the view
+     * converts the newest frame on a background thread and the window paints
+     * the last finished image, so a slow conversion does not block the
+     * scrolling, zooming and the other windows of the application. The
+     * frames arriving during a conversion are dropped except the newest one.
+     * The viewport conversion and the partial update of the modified regions
+     * are not used in this mode.
+     *
+     * @param in_enable     The asynchronous conversion setting
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_async_conversion(bool in_enable,
+                              bool in_skip_frame_counter_update = true)
+    {
+      if (m_async_conversion == in_enable)
+        return;
+      m_async_conversion = in_enable;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // is_async_conversion_enabled
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the asynchronous conversion setting.
+     *
+     * @return  The asynchronous conversion setting
+     */
+    [[nodiscard]] bool is_async_conversion_enabled() const
+    {
+      return m_async_conversion;
+    }
+    // -------------------------------------------------------------------------
+    // set_frame_clock_pacing
+    // -------------------------------------------------------------------------
+    /**
+     * Enables or disables the presentation paced by the frame clock of the
+     * display. When enabled, the window checks the image buffer once per
+     * refresh of the display and presents the newest frame only. The frames
+     * updated faster than the refresh rate are skipped without being
+     * converted, and the updates are not posted to the application thread.
+     *
+     * @param in_enable     The frame clock pacing setting
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_frame_clock_pacing(bool in_enable,
+                                bool in_skip_frame_counter_update = true)
+    {
+      if (m_frame_clock_pacing == in_enable)
+        return;
+      m_frame_clock_pacing = in_enable;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // is_frame_clock_pacing_enabled
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the frame clock pacing setting.
+     *
+     * @return  The frame clock pacing setting
+     */
+    [[nodiscard]] bool is_frame_clock_pacing_enabled() const
+    {
+      return m_frame_clock_pacing;
+    }
+    // -------------------------------------------------------------------------
+    // is_viewport_conversion_enabled
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the viewport conversion setting.
+     *
+     * @return  The viewport conversion setting
+     */
+    [[nodiscard]] bool is_viewport_conversion_enabled() const
+    {
+      return m_viewport_conversion;
+    }
+    // -------------------------------------------------------------------------
+    // set_viewport_conversion
+    // -------------------------------------------------------------------------
+    /**
+     * Enables or disables the viewport conversion. When enabled, the view
+     * converts only the region of the image visible in the window (plus a
+     * small margin) for each frame, and converts the rest on demand while
+     * panning and zooming. This reduces the display cost of the large images
+     * viewed at the high zoom ratio.
+     *
+     * @param in_enable     The viewport conversion setting
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_viewport_conversion(bool in_enable,
+                                 bool in_skip_frame_counter_update = true)
+    {
+      if (m_viewport_conversion == in_enable)
+        return;
+      m_viewport_conversion = in_enable;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // get_yuv_matrix
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the color matrix used to display the YUV image buffer.
+     *
+     * @return  The color matrix of the image buffer
+     */
+    [[nodiscard]] YUVMatrix get_yuv_matrix() const
+    {
+      return m_yuv_matrix;
+    }
+    // -------------------------------------------------------------------------
+    // set_yuv_matrix
+    // -------------------------------------------------------------------------
+    /**
+     * Set the color matrix used to display the YUV image buffer (YUYV, UYVY,
+     * NV12 and I420). The YUV values are treated as the limited (video) range.
+     *
+     * @param in_matrix     The color matrix
+     *  - YUV_MATRIX_BT601 : ITU-R BT.601 (default, SD video and most webcams)
+     *  - YUV_MATRIX_BT709 : ITU-R BT.709 (HD video)
+     * @param in_skip_frame_counter_update
+     *  - true : Will skip incrementing the frame counter
+     *  - false : Will not increment the frame counter
+     */
+    void set_yuv_matrix(YUVMatrix in_matrix,
+                        bool in_skip_frame_counter_update = true)
+    {
+      if (m_yuv_matrix == in_matrix)
+        return;
+      m_yuv_matrix = in_matrix;
+      mark_as_modified(in_skip_frame_counter_update);
+    }
+    // -------------------------------------------------------------------------
+    // get_width
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the width of the image buffer.
+     *
+     * @return The width of the image buffer
+     */
+    [[nodiscard]] int get_width() const
+    {
+      return m_width;
+    }
+    // -------------------------------------------------------------------------
+    // get_height
+    // -------------------------------------------------------------------------
+    /**
+     * Retries the height of the image buffer.
+     *
+     * @return The height of the image buffer
+     */
+    [[nodiscard]] int get_height() const
+    {
+      return m_height;
+    }
+    // -------------------------------------------------------------------------
+    // is_mono
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the type of the image buffer (Mono or Color).
+     *
+     * @return The image buffer type
+     *  - true : The image buffer type is monochrome (MONO8, MONO16 or MONO32F)
+     *  - false : The image buffer type is color (RGB8, BGR8, BGRA8 or RGBA8)
+     */
+    [[nodiscard]] bool is_mono() const
+    {
+      return is_mono(m_pixel_format);
+    }
+    // -------------------------------------------------------------------------
+    // get_pixel_format
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the pixel format of the image buffer.
+     *
+     * @return The pixel format of the image buffer
+     */
+    [[nodiscard]] PixelFormat get_pixel_format() const
+    {
+      return m_pixel_format;
+    }
+    // -------------------------------------------------------------------------
+    // get_stride
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the distance between the rows of the image buffer.
+     *
+     * @return The stride of the image (bytes)
+     */
+    [[nodiscard]] size_t get_stride() const
+    {
+      return m_stride;
+    }
+    // -------------------------------------------------------------------------
+    // get_buffer_size
+    // -------------------------------------------------------------------------
+    /**
+     * Retrieves the size of the image buffer on the memory.
+     *
+     * @return The size of the image (bytes)
+     */
+    [[nodiscard]] size_t get_buffer_size() const
+    {
+      return m_buffer_size;
+    }
+    // -------------------------------------------------------------------------
+    // is_valid
+    // -------------------------------------------------------------------------
+    /**
+     * Checks whether the object holds a valid image buffer or not.
+     * @note To become the valid state, allocate() or set_external_buffer()
+     * needs to be called and returns with the success
+     *
+     * @return
+     *  - true : The image buffer is valid.
+     *  - false : The image buffer is invalid.
+     */
+    [[nodiscard]] bool is_valid() const
+    {
+      if (m_allocated_buffer_ptr == nullptr && m_external_buffer_ptr == nullptr)
+        return false;
+      if (m_width == 0 || m_height == 0 || m_buffer_size == 0)
+        return false;
+      return true;
+    }
+
+    // Static Functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // is_mono
+    // -------------------------------------------------------------------------
+    static bool is_mono(PixelFormat in_format)
+    {
+      switch (in_format)
+      {
+        case PIXEL_FORMAT_MONO8:
+        case PIXEL_FORMAT_MONO16:
+        case PIXEL_FORMAT_MONO32F:
+          return true;
+        default:
+          break;
+      }
+      return false;
+    }
+    // -------------------------------------------------------------------------
+    // get_bytes_per_pixel
+    // -------------------------------------------------------------------------
+    static size_t get_bytes_per_pixel(PixelFormat in_format)
+    {
+      switch (in_format)
+      {
+        case PIXEL_FORMAT_MONO8:
+        case PIXEL_FORMAT_BAYER_RG8:
+        case PIXEL_FORMAT_BAYER_GB8:
+        case PIXEL_FORMAT_BAYER_GR8:
+        case PIXEL_FORMAT_BAYER_BG8:
+        case PIXEL_FORMAT_NV12:   // Y plane
+        case PIXEL_FORMAT_I420:   // Y plane
+          return 1;
+        case PIXEL_FORMAT_RGB8:
+          return 3;
+        case PIXEL_FORMAT_MONO16:
+        case PIXEL_FORMAT_YUYV:
+        case PIXEL_FORMAT_UYVY:
+          return 2;
+        case PIXEL_FORMAT_MONO32F:
+        case PIXEL_FORMAT_BGRA8:
+        case PIXEL_FORMAT_RGBA8:
+          return 4;
+        case PIXEL_FORMAT_BGR8:
+          return 3;
+        default:
+          break;
+      }
+      return 0;
+    }
+    // -------------------------------------------------------------------------
+    // get_pixel_format_name
+    // -------------------------------------------------------------------------
+    static const char *get_pixel_format_name(PixelFormat in_format)
+    {
+      switch (in_format)
+      {
+        case PIXEL_FORMAT_MONO8:
+          return "MONO8";
+        case PIXEL_FORMAT_RGB8:
+          return "RGB8";
+        case PIXEL_FORMAT_MONO16:
+          return "MONO16";
+        case PIXEL_FORMAT_MONO32F:
+          return "MONO32F";
+        case PIXEL_FORMAT_BGRA8:
+          return "BGRA8";
+        case PIXEL_FORMAT_RGBA8:
+          return "RGBA8";
+        case PIXEL_FORMAT_BGR8:
+          return "BGR8";
+        case PIXEL_FORMAT_BAYER_RG8:
+          return "BayerRG8";
+        case PIXEL_FORMAT_BAYER_GB8:
+          return "BayerGB8";
+        case PIXEL_FORMAT_BAYER_GR8:
+          return "BayerGR8";
+        case PIXEL_FORMAT_BAYER_BG8:
+          return "BayerBG8";
+        case PIXEL_FORMAT_YUYV:
+          return "YUYV";
+        case PIXEL_FORMAT_UYVY:
+          return "UYVY";
+        case PIXEL_FORMAT_NV12:
+          return "NV12";
+        case PIXEL_FORMAT_I420:
+          return "I420";
+        default:
+          break;
+      }
+      return "";
+    }
+    // -------------------------------------------------------------------------
+    // get_plane_num
+    // -------------------------------------------------------------------------
+    static int get_plane_num(PixelFormat in_format)
+    {
+      switch (in_format)
+      {
+        case PIXEL_FORMAT_NV12:
+          return 2;
+        case PIXEL_FORMAT_I420:
+          return 3;
+        default:
+          break;
+      }
+      return 1;
+    }
+    // -------------------------------------------------------------------------
+    // get_plane_packed_stride
+    // -------------------------------------------------------------------------
+    static size_t get_plane_packed_stride(PixelFormat in_format, int in_width, int in_index)
+    {
+      if (in_index == 0)
+        return (size_t )in_width * get_bytes_per_pixel(in_format);
+      if (in_format == PIXEL_FORMAT_NV12)
+        return (size_t )in_width;
+      return (size_t )in_width / 2;
+    }
+    // -------------------------------------------------------------------------
+    // is_valid_width
+    // -------------------------------------------------------------------------
+    // The YUV formats share a chroma sample between 2 horizontal pixels
+    //
+    static bool is_valid_width(PixelFormat in_format, int in_width)
+    {
+      switch (in_format)
+      {
+        case PIXEL_FORMAT_YUYV:
+        case PIXEL_FORMAT_UYVY:
+        case PIXEL_FORMAT_NV12:
+        case PIXEL_FORMAT_I420:
+          return (in_width % 2) == 0;
+        default:
+          break;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // get_bayer_red_position
+    // -------------------------------------------------------------------------
+    // Retrieves the position of the red pixel in the 2x2 Bayer cell.
+    // Returns false if the format is not a Bayer format
+    //
+    static bool get_bayer_red_position(PixelFormat in_format, int *out_x, int *out_y)
+    {
+      switch (in_format)
+      {
+        case PIXEL_FORMAT_BAYER_RG8:
+          *out_x = 0;
+          *out_y = 0;
+          return true;
+        case PIXEL_FORMAT_BAYER_GR8:
+          *out_x = 1;
+          *out_y = 0;
+          return true;
+        case PIXEL_FORMAT_BAYER_GB8:
+          *out_x = 0;
+          *out_y = 1;
+          return true;
+        case PIXEL_FORMAT_BAYER_BG8:
+          *out_x = 1;
+          *out_y = 1;
+          return true;
+        default:
+          break;
+      }
+      return false;
+    }
+
+  protected:
+    // -------------------------------------------------------------------------
+    // Data constructor
+    // -------------------------------------------------------------------------
+    Data()
+    {
+      m_allocated_buffer_ptr = nullptr;
+      m_external_buffer_ptr = nullptr;
+      m_buffer_size = 0;
+      m_slot_size = 0;
+      m_stride = 0;
+      m_width = 0;
+      m_height = 0;
+      m_pixel_format = PIXEL_FORMAT_NOT_SPECIFIED;
+      m_is_image_modified.store(false, std::memory_order_release);
+      m_is_whole_image_modified = false;
+      m_colormap_index = Colormap::COLORMAP_GrayScale;
+      m_window_level_window = 65536;
+      m_window_level_level = 32768;
+      m_float_auto_range = true;
+      m_float_range_min = 0.0;
+      m_float_range_max = 1.0;
+      m_is_display_window_level = false;
+      m_display_window = 256.0;
+      m_display_level = 128.0;
+      m_demosaic_mode = DEMOSAIC_BILINEAR;
+      m_yuv_matrix = YUV_MATRIX_BT601;
+      m_viewport_conversion = false;
+      m_async_conversion = false;
+      m_frame_clock_pacing = false;
+      m_is_frame_tick_running = false;
+      for (int i = 0; i < MAX_PLANE_NUM; i++)
+      {
+        m_plane_ptr[i] = nullptr;
+        m_plane_stride[i] = 0;
+      }
+      reset_slots(1);
+      m_submitted_frame_counter = 0;
+      reset_frame_counter();
+      reset_frame_statistics();
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // cleanup_buffers
+    // -------------------------------------------------------------------------
+    void cleanup_buffers()
+    {
+      if (m_allocated_buffer_ptr != nullptr)
+      {
+        BufferPool::get_pool()->release(m_allocated_buffer_ptr);
+        m_allocated_buffer_ptr = nullptr;
+      }
+      reset_slots(1);
+      release_submitted_buffers();
+      m_external_buffer_ptr = nullptr;
+      m_buffer_size = 0;
+      m_slot_size = 0;
+      m_stride = 0;
+      for (int i = 0; i < MAX_PLANE_NUM; i++)
+      {
+        m_plane_ptr[i] = nullptr;
+        m_plane_stride[i] = 0;
+      }
+      m_width = 0;
+      m_height = 0;
+      m_pixel_format = PIXEL_FORMAT_NOT_SPECIFIED;
+      clear_modified_flag();
+    }
+    // -------------------------------------------------------------------------
+    // allocate_slots
+    // -------------------------------------------------------------------------
+    bool allocate_slots(int in_width, int in_height, PixelFormat in_format, int in_slot_num)
+    {
+      if (in_width == 0 || in_height == 0 ||
+          get_bytes_per_pixel(in_format) == 0 ||
+          is_valid_width(in_format, in_width) == false)
+      {
+        cleanup_buffers();
+        return false;
+      }
+      // The same geometry keeps the current buffer (and its contents)
+      if (m_allocated_buffer_ptr != nullptr &&
+          m_width == in_width && m_height == in_height &&
+          m_pixel_format == in_format && m_slot_num == in_slot_num)
+      {
+        reset_slots(in_slot_num);
+        update_planes(m_allocated_buffer_ptr);
+        return true;
+      }
+      if (m_allocated_buffer_ptr != nullptr)
+      {
+        BufferPool::get_pool()->release(m_allocated_buffer_ptr);
+        m_allocated_buffer_ptr = nullptr;
+      }
+      release_submitted_buffers();
+      m_external_buffer_ptr = nullptr;
+      m_width = in_width;
+      m_height = in_height;
+      m_pixel_format = in_format;
+      m_stride = (size_t )in_width * get_bytes_per_pixel(in_format);
+      update_planes(nullptr);
+      update_image_buffer_size();
+      // Each slot starts at the aligned address
+      m_slot_size = (m_buffer_size + BufferPool::ALIGNMENT - 1) & ~(BufferPool::ALIGNMENT - 1);
+      m_allocated_buffer_ptr = BufferPool::get_pool()->acquire(m_slot_size * in_slot_num);
+      if (m_allocated_buffer_ptr == nullptr)
+      {
+        cleanup_buffers();
+        return false;
+      }
+      ::memset(m_allocated_buffer_ptr, 0, m_slot_size * in_slot_num);
+      reset_slots(in_slot_num);
+      update_planes(m_allocated_buffer_ptr);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // reset_slots
+    // -------------------------------------------------------------------------
+    // Slot 0 is the front buffer (read by the view), slot 1 is the latest
+    // published frame and slot 2 is the back buffer (written by the producer)
+    //
+    void reset_slots(int in_slot_num)
+    {
+      m_slot_num = in_slot_num;
+      m_front_slot = 0;
+      m_back_slot = (in_slot_num == TRIPLE_BUFFER_NUM) ? 2 : 0;
+      m_latest_slot.store(in_slot_num == TRIPLE_BUFFER_NUM ? 1 : 0, std::memory_order_release);
+      m_published_frame_counter = 0;
+      for (unsigned int &counter : m_slot_frame_counter)
+        counter = 0;
+    }
+    // -------------------------------------------------------------------------
+    // get_slot
+    // -------------------------------------------------------------------------
+    [[nodiscard]] uint8_t *get_slot(unsigned int in_slot) const
+    {
+      return m_allocated_buffer_ptr + m_slot_size * in_slot;
+    }
+    // -------------------------------------------------------------------------
+    // acquire_submitted_buffer
+    // -------------------------------------------------------------------------
+    // Called by the view (UI thread). Switches to the pending submitted
+    // buffer. The previous buffer is kept until release_retired_buffer() is
+    // called after the conversion (a wrapped surface may still refer to it)
+    //
+    bool acquire_submitted_buffer()
+    {
+      SubmittedBuffer submission;
+      {
+        std::lock_guard<std::mutex> lock(m_submit_mutex);
+        if (!m_pending_submission.buffer)
+          return false;
+        submission = std::move(m_pending_submission);
+        m_pending_submission.buffer.reset();
+      }
+      if (m_allocated_buffer_ptr != nullptr)
+      {
+        BufferPool::get_pool()->release(m_allocated_buffer_ptr);
+        m_allocated_buffer_ptr = nullptr;
+      }
+      reset_slots(1);
+      m_retired_buffer = std::move(m_displayed_buffer);
+      m_displayed_buffer = std::move(submission.buffer);
+      m_external_buffer_ptr = m_displayed_buffer.get();
+      m_width = submission.width;
+      m_height = submission.height;
+      m_pixel_format = submission.format;
+      m_stride = submission.stride;
+      update_planes(m_external_buffer_ptr);
+      update_image_buffer_size();
+      set_frame_counter(submission.frame_counter);
+      mark_whole_image_modified();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // release_retired_buffer
+    // -------------------------------------------------------------------------
+    void release_retired_buffer()
+    {
+      m_retired_buffer.reset();
+    }
+    // -------------------------------------------------------------------------
+    // release_submitted_buffers
+    // -------------------------------------------------------------------------
+    // Drops the submitted buffers used by the view (the pending one is kept)
+    //
+    void release_submitted_buffers()
+    {
+      m_retired_buffer.reset();
+      m_displayed_buffer.reset();
+    }
+    // -------------------------------------------------------------------------
+    // take_modified_regions
+    // -------------------------------------------------------------------------
+    // Called by the view when it displays the image. Moves the modified
+    // regions to out_regions and clears the modified flag. Returns false if
+    // the whole image is modified
+    //
+    bool take_modified_regions(std::vector<Region> *out_regions)
+    {
+      std::lock_guard<std::mutex> lock(m_modified_region_mutex);
+      bool is_partial = (m_is_whole_image_modified == false);
+      out_regions->swap(m_modified_regions);
+      m_modified_regions.clear();
+      m_is_whole_image_modified = false;
+      m_is_image_modified.store(false, std::memory_order_release);
+      return is_partial;
+    }
+    // -------------------------------------------------------------------------
+    // is_new_frame_pending
+    // -------------------------------------------------------------------------
+    // Whether the next redraw swaps in a new frame (published back buffer or
+    // submitted buffer)
+    //
+    bool is_new_frame_pending()
+    {
+      if (is_triple_buffer_enabled() &&
+          (m_latest_slot.load(std::memory_order_relaxed) & LATEST_SLOT_FRESH) != 0)
+        return true;
+      std::lock_guard<std::mutex> lock(m_submit_mutex);
+      return (bool )m_pending_submission.buffer;
+    }
+    // -------------------------------------------------------------------------
+    // set_frame_tick_running
+    // -------------------------------------------------------------------------
+    // Called by the view (UI thread) when its frame tick is added or removed
+    //
+    void set_frame_tick_running(bool in_is_running)
+    {
+      std::lock_guard<std::mutex> lock(m_frame_tick_mutex);
+      m_is_frame_tick_running.store(in_is_running);
+    }
+    // -------------------------------------------------------------------------
+    // stop_frame_tick_if_idle
+    // -------------------------------------------------------------------------
+    // Called by the view on each frame of the display. Returns true (and clears
+    // the running flag) if nothing is to be presented, and then the next
+    // update() is posted to the BackgroundApp to restart the tick
+    //
+    bool stop_frame_tick_if_idle()
+    {
+      std::lock_guard<std::mutex> lock(m_frame_tick_mutex);
+      if (m_is_image_modified.load(std::memory_order_acquire) || is_new_frame_pending())
+        return false;
+      m_is_frame_tick_running.store(false);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // mark_as_displayed
+    // -------------------------------------------------------------------------
+    // Called by the view when the image is presented. Only the presentations
+    // of new frames are counted (not the redraws by the setting changes)
+    //
+    void mark_as_displayed()
+    {
+      uint64_t produced = m_produced_frame_num.load(std::memory_order_acquire);
+      // reset_frame_statistics() may store 0 from another thread
+      if (m_last_displayed_produced_num.exchange(produced, std::memory_order_acq_rel) == produced)
+        return;
+      m_displayed_frame_num.fetch_add(1, std::memory_order_release);
+    }
+    // -------------------------------------------------------------------------
+    // acquire_latest_frame
+    // -------------------------------------------------------------------------
+    // Called by the view (UI thread). Swaps the front buffer with the latest
+    // published frame if there is a new one and marks the image as modified
+    //
+    bool acquire_latest_frame()
+    {
+      if (is_triple_buffer_enabled() == false)
+        return false;
+      if ((m_latest_slot.load(std::memory_order_relaxed) & LATEST_SLOT_FRESH) == 0)
+        return false;
+      unsigned int prev = m_latest_slot.exchange(m_front_slot, std::memory_order_acq_rel);
+      m_front_slot = prev & LATEST_SLOT_INDEX_MASK;
+      update_planes(get_image());
+      set_frame_counter(m_slot_frame_counter[m_front_slot]);
+      mark_whole_image_modified();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // update_image_buffer_size
+    // -------------------------------------------------------------------------
+    void update_image_buffer_size()
+    {
+      m_buffer_size = 0;
+      for (int i = 0; i < get_plane_num(m_pixel_format); i++)
+        m_buffer_size += get_plane_stride(i) * get_plane_height(i);
+      //
+    }
+    // -------------------------------------------------------------------------
+    // update_planes
+    // -------------------------------------------------------------------------
+    // Places the chroma planes of NV12 and I420 after the Y plane of the
+    // contiguous buffer (only the strides are updated if in_buffer_ptr is nullptr)
+    //
+    void update_planes(uint8_t *in_buffer_ptr)
+    {
+      for (int i = 1; i < MAX_PLANE_NUM; i++)
+      {
+        m_plane_ptr[i] = nullptr;
+        m_plane_stride[i] = 0;
+      }
+      if (m_pixel_format == PIXEL_FORMAT_NV12)
+      {
+        m_plane_stride[1] = m_stride;
+      }
+      else if (m_pixel_format == PIXEL_FORMAT_I420)
+      {
+        m_plane_stride[1] = (m_stride + 1) / 2;
+        m_plane_stride[2] = m_plane_stride[1];
+      }
+      if (in_buffer_ptr == nullptr)
+        return;
+      uint8_t *ptr = in_buffer_ptr + m_stride * m_height;
+      for (int i = 1; i < get_plane_num(m_pixel_format); i++)
+      {
+        m_plane_ptr[i] = ptr;
+        ptr += m_plane_stride[i] * get_plane_height(i);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // get_yuv_value
+    // -------------------------------------------------------------------------
+    void get_yuv_value(int in_x, int in_y, double *out_y, double *out_u, double *out_v) const
+    {
+      const uint8_t *row = get_image() + (size_t )in_y * m_stride;
+      const uint8_t *pair = row + (in_x / 2) * 4;
+      const uint8_t *chroma;
+      switch (m_pixel_format)
+      {
+        case PIXEL_FORMAT_YUYV:
+          *out_y = pair[(in_x & 1) * 2];
+          *out_u = pair[1];
+          *out_v = pair[3];
+          break;
+        case PIXEL_FORMAT_UYVY:
+          *out_y = pair[(in_x & 1) * 2 + 1];
+          *out_u = pair[0];
+          *out_v = pair[2];
+          break;
+        case PIXEL_FORMAT_NV12:
+          chroma = m_plane_ptr[1] + (in_y / 2) * m_plane_stride[1] + (in_x / 2) * 2;
+          *out_y = row[in_x];
+          *out_u = chroma[0];
+          *out_v = chroma[1];
+          break;
+        case PIXEL_FORMAT_I420:
+          *out_y = row[in_x];
+          *out_u = m_plane_ptr[1][(in_y / 2) * m_plane_stride[1] + in_x / 2];
+          *out_v = m_plane_ptr[2][(in_y / 2) * m_plane_stride[2] + in_x / 2];
+          break;
+        default:
+          break;
+      }
+    }
+    // -------------------------------------------------------------------------
+    // to_pixel_int
+    // -------------------------------------------------------------------------
+    // Truncates the pixel value for the int version of get_pixel_value().
+    // NaN gives 0 and the values outside of the int range are saturated
+    //
+    static int to_pixel_int(double in_v)
+    {
+      if (std::isnan(in_v))
+        return 0;
+      if (in_v >= (double )INT_MAX)
+        return INT_MAX;
+      if (in_v <= (double )INT_MIN)
+        return INT_MIN;
+      return (int )in_v;
+    }
+    // -------------------------------------------------------------------------
+    // mark_for_frame_tick
+    // -------------------------------------------------------------------------
+    // Called by update() on the calling thread in the frame clock pacing mode.
+    // Returns false if the frame tick of the view is not running (the update
+    // has to be posted to the BackgroundApp). The running flag is kept here,
+    // not in the view, since the window may be deleted on the UI thread, and
+    // the tick checks the modified flag under the same lock before it stops
+    //
+    bool mark_for_frame_tick(bool in_mark_as_modified)
+    {
+      if (m_is_frame_tick_running.load() == false)
+        return false;
+      std::lock_guard<std::mutex> lock(m_frame_tick_mutex);
+      if (m_is_frame_tick_running.load() == false)
+        return false;
+      if (in_mark_as_modified)
+      {
+        // Counted by the producer side calls (see ImageWindow::update_window())
+        mark_as_modified(true);
+        increment_frame_counter();
+      }
+      return true;
+    }
+
+  private:
+    // -------------------------------------------------------------------------
+    // SubmittedBuffer
+    // -------------------------------------------------------------------------
+    struct SubmittedBuffer
+    {
+      std::shared_ptr<uint8_t> buffer;
+      int width = 0;
+      int height = 0;
+      PixelFormat format = PIXEL_FORMAT_NOT_SPECIFIED;
+      size_t stride = 0;
+      unsigned int frame_counter = 0;
+    };
+
+    // -------------------------------------------------------------------------
+    // mark_whole_image_modified
+    // -------------------------------------------------------------------------
+    void mark_whole_image_modified()
+    {
+      std::lock_guard<std::mutex> lock(m_modified_region_mutex);
+      m_is_whole_image_modified = true;
+      m_modified_regions.clear();
+      m_is_image_modified.store(true, std::memory_order_release);
+    }
+    // -------------------------------------------------------------------------
+    // add_modified_region
+    // -------------------------------------------------------------------------
+    // Adds [in_x0, in_x1) x [in_y0, in_y1) merging the overlapping or adjacent
+    // regions (m_modified_region_mutex must be locked)
+    //
+    void add_modified_region(int in_x0, int in_y0, int in_x1, int in_y1)
+    {
+      bool merged = true;
+      while (merged)
+      {
+        merged = false;
+        for (size_t i = 0; i < m_modified_regions.size(); i++)
+        {
+          const Region &r = m_modified_regions[i];
+          if (in_x0 > r.x + r.width || r.x > in_x1 ||
+              in_y0 > r.y + r.height || r.y > in_y1)
+            continue;
+          in_x0 = std::min(in_x0, r.x);
+          in_y0 = std::min(in_y0, r.y);
+          in_x1 = std::max(in_x1, r.x + r.width);
+          in_y1 = std::max(in_y1, r.y + r.height);
+          m_modified_regions.erase(m_modified_regions.begin() + i);
+          merged = true;
+          break;
+        }
+      }
+      if ((int )m_modified_regions.size() >= MAX_MODIFIED_REGION_NUM)
+      {
+        for (const Region &r : m_modified_regions)
+        {
+          in_x0 = std::min(in_x0, r.x);
+          in_y0 = std::min(in_y0, r.y);
+          in_x1 = std::max(in_x1, r.x + r.width);
+          in_y1 = std::max(in_y1, r.y + r.height);
+        }
+        m_modified_regions.clear();
+      }
+      m_modified_regions.push_back({in_x0, in_y0, in_x1 - in_x0, in_y1 - in_y0});
+    }
+
+    // Constants ---------------------------------------------------------------
+    static constexpr unsigned int LATEST_SLOT_INDEX_MASK = 0x03;
+    static constexpr unsigned int LATEST_SLOT_FRESH = 0x04;
+
+    // member variables --------------------------------------------------------
+    uint8_t *m_allocated_buffer_ptr;
+    uint8_t *m_external_buffer_ptr;
+    size_t m_buffer_size;
+    size_t m_slot_size;
+    size_t m_stride;
+    int m_width;
+    int m_height;
+    PixelFormat m_pixel_format;
+    Colormap::ColormapIndex m_colormap_index;
+    int m_window_level_window;
+    int m_window_level_level;
+    bool m_float_auto_range;
+    double m_float_range_min;
+    double m_float_range_max;
+    mutable std::mutex m_display_window_level_mutex;
+    bool m_is_display_window_level;
+    double m_display_window;
+    double m_display_level;
+    DemosaicMode m_demosaic_mode;
+    YUVMatrix m_yuv_matrix;
+    bool m_viewport_conversion;
+    bool m_async_conversion;
+    bool m_frame_clock_pacing;
+    std::mutex m_frame_tick_mutex;
+    std::atomic<bool> m_is_frame_tick_running;
+    uint8_t *m_plane_ptr[MAX_PLANE_NUM];
+    size_t m_plane_stride[MAX_PLANE_NUM];
+    bool m_frame_counter_initialized;
+    unsigned int m_frame_counter;
+    int m_slot_num;
+    unsigned int m_front_slot;
+    unsigned int m_back_slot;
+    std::atomic<unsigned int> m_latest_slot;  // slot index | LATEST_SLOT_FRESH
+    unsigned int m_published_frame_counter;
+    unsigned int m_slot_frame_counter[TRIPLE_BUFFER_NUM];
+    std::atomic<uint64_t> m_produced_frame_num;
+    std::atomic<uint64_t> m_displayed_frame_num;
+    std::atomic<uint64_t> m_last_displayed_produced_num;
+    std::mutex m_submit_mutex;
+    SubmittedBuffer m_pending_submission;
+    unsigned int m_submitted_frame_counter;
+    std::shared_ptr<uint8_t> m_displayed_buffer;
+    std::shared_ptr<uint8_t> m_retired_buffer;
+
+    std::atomic<bool> m_is_image_modified;
+    bool m_is_whole_image_modified;
+    std::mutex m_modified_region_mutex;
+    std::vector<Region> m_modified_regions;
+
+    // friend classes ----------------------------------------------------------
+    friend class View;
+  };
+
+  // ===========================================================================
+  //  UpdateHandlerInterface class
+  // ===========================================================================
+  class UpdateHandlerInterface
+  {
+  public:
+    virtual void view_zoom_updated(double in_zoom, bool in_best_fit) = 0;
+    virtual void view_image_info_updated(bool in_is_valid_image_info,
+                                int in_image_width, int in_image_height,
+                                bool in_is_image_mono) = 0;
+    virtual void view_mouse_info_updated(bool in_is_valid_mouse_info,
+                                            int in_mouse_x, int in_mouse_y,
+                                            bool in_is_mouse_mono,
+                                            int in_mouse_r, int in_mouse_g, int in_mouse_b) = 0;
+    virtual void view_frame_info_updated(bool in_is_valid_frame_info,
+                                        unsigned int in_frame_count, double in_fps) = 0;
+
+    // The handlers below are optional (the default ones do nothing). Each one
+    // is called just before the required handler of the same event (on the
+    // UI thread), so an implementation can keep the values and use them in
+    // the required handler (MainWindow does so for its status bar)
+    virtual void view_image_format_updated(bool /* in_is_valid_image_info */,
+                                           Data::PixelFormat /* in_image_format */) {}
+    virtual void view_mouse_value_updated(bool /* in_is_valid_mouse_info */,
+                                          int /* in_mouse_x */, int /* in_mouse_y */,
+                                          bool /* in_is_mouse_mono */,
+                                          double /* in_mouse_r */, double /* in_mouse_g */,
+                                          double /* in_mouse_b */) {}
+    virtual void view_frame_stats_updated(uint64_t /* in_produced_num */,
+                                          uint64_t /* in_displayed_num */) {}
+    // This one is called when the display window/level is changed by the view
+    virtual void view_window_level_updated(bool /* in_is_overridden */,
+                                           double /* in_window */, double /* in_level */) {}
+  };
+
+  // ===========================================================================
+  // View class
+  // ===========================================================================
+  // Note: Order of Scrollable -> Widget is very important
+  //
+  class View : virtual public Gtk::Scrollable, virtual public Gtk::Widget
+  {
+    // Class related macros
+#define IM_VIEW_COLORMAP_COLOR_NUM      256
+#define IM_VIEW_COLORMAP_DATA_SIZE      (IM_VIEW_COLORMAP_COLOR_NUM * 3)
+#define IM_VIEW_PARALLEL_MIN_PIXEL_NUM  (512 * 512)
+#define IM_VIEW_WINDOW_LEVEL_DRAG_STEP  256.0
+
+  public:
+    // -------------------------------------------------------------------------
+    // View destructor
+    // -------------------------------------------------------------------------
+    ~View() override
+    {
+      stop_frame_tick();
+      m_conversion_thread.stop();
+      SHL_DBG_OUT("View was deleted");
+    }
+
+  protected:
+    // -------------------------------------------------------------------------
+    // View constructor
+    // -------------------------------------------------------------------------
+    View() :
+            Glib::ObjectBase("View"),
+            m_h_adjustment(*this, "hadjustment"),
+            m_v_adjustment(*this, "vadjustment"),
+            m_h_scroll_policy(*this, "hscroll-policy", Gtk::SCROLL_NATURAL),
+            m_v_scroll_policy(*this, "vscroll-policy", Gtk::SCROLL_NATURAL)
+    {
+      set_has_window(true);
+      property_hadjustment().signal_changed().connect(sigc::mem_fun(
+              *this, &shl::gtk::image::View::h_adjustment_changed));
+      property_vadjustment().signal_changed().connect(sigc::mem_fun(
+              *this, &shl::gtk::image::View::v_adjustment_changed));
+      m_async_dispatcher.connect(sigc::mem_fun(
+              *this, &shl::gtk::image::View::on_async_conversion_done));
+
+      m_width = 0;
+      m_height = 0;
+      m_org_width = 0;
+      m_org_height = 0;
+      m_mouse_x = 0;
+      m_mouse_y = 0;
+      m_mouse_info_x = 0;
+      m_mouse_info_y = 0;
+      m_mouse_info_updated = false;
+      m_offset_x = 0;
+      m_offset_y = 0;
+      m_offset_x_max = 0;
+      m_offset_y_max = 0;
+      m_offset_x_org = 0;
+      m_offset_y_org = 0;
+      m_window_x = 0;
+      m_window_y = 0;
+      m_window_width = 0;
+      m_window_height = 0;
+      m_zoom = 1.0;
+      m_zoom_best_fit = false;
+      m_mouse_l_pressed = false;
+      m_mouse_r_pressed = false;
+      m_window_org = 0;
+      m_level_org = 0;
+      m_adjustments_modified = false;
+
+      m_image_data_ptr = nullptr;
+      m_is_image_size_changed = false;
+      m_pixel_format = Data::PIXEL_FORMAT_NOT_SPECIFIED;
+      m_is_surface_wrapped = false;
+      m_scaled_level = -1;
+      m_is_async_job_posted = false;
+      m_frame_tick_id = 0;
+      m_is_drawn_origin_valid = false;
+      m_drawn_origin_x = 0;
+      m_drawn_origin_y = 0;
+      m_drawn_zoom = 0;
+      m_is_zoomed_image_valid = false;
+      m_zoomed_source = nullptr;
+      m_zoomed_zoom = 0;
+      m_zoomed_origin_x = 0;
+      m_zoomed_origin_y = 0;
+      m_zoomed_x_start = 0;
+      m_zoomed_y_start = 0;
+      m_zoomed_x_end = 0;
+      m_zoomed_y_end = 0;
+
+      m_fps = 0;
+      m_fps_sum = 0;
+      m_fps_sum_num = 0;
+
+      m_colormap_index = Colormap::COLORMAP_NOT_SPECIFIED;
+      m_colormap_lut = Colormap::get_shared_colormap(m_colormap_index,
+                                                     IM_VIEW_COLORMAP_COLOR_NUM);
+      m_colormap = m_colormap_lut.get();
+      m_is_colormap32_valid = false;
+      m_mono8_lut_window = 0;
+      m_mono8_lut_level = 0;
+      m_mono16_lut_window = 0;
+      m_mono16_lut_level = 0;
+      m_float_min = 0;
+      m_float_max = 1.0;
+      m_presented_float_min = 0;
+      m_presented_float_max = 1.0;
+      clear_converted_region();
+
+      add_events(Gdk::SCROLL_MASK |
+                 Gdk::BUTTON_MOTION_MASK | Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK |
+                 Gdk::POINTER_MOTION_MASK | Gdk::LEAVE_NOTIFY_MASK);
+    }
+
+    // Member functions --------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // set_image_data
+    // -------------------------------------------------------------------------
+    void set_image_data(Data *inImageDataPtr)
+    {
+      m_conversion_thread.wait();
+      stop_frame_tick();
+      m_image_data_ptr = inImageDataPtr;
+      queue_draw();
+    }
+    // -------------------------------------------------------------------------
+    // get_image_data
+    // -------------------------------------------------------------------------
+    Data *get_image_data()
+    {
+      return m_image_data_ptr;
+    }
+    // -------------------------------------------------------------------------
+    // add_update_handler
+    // -------------------------------------------------------------------------
+    void add_update_handler(UpdateHandlerInterface *in_handler)
+    {
+      m_update_handlers.push_back(in_handler);
+    }
+    // -------------------------------------------------------------------------
+    // remove_update_handler
+    // -------------------------------------------------------------------------
+    void remove_update_handler(UpdateHandlerInterface *in_handler)
+    {
+      auto it = std::find(m_update_handlers.begin(),
+                          m_update_handlers.end(),
+                          in_handler);
+      if (it == m_update_handlers.end())
+        return;
+      m_update_handlers.erase(it);
+    }
+    // -------------------------------------------------------------------------
+    // get_zoom
+    // -------------------------------------------------------------------------
+    double get_zoom()
+    {
+      return m_zoom;
+    }
+    // -------------------------------------------------------------------------
+    // set_zoom
+    // -------------------------------------------------------------------------
+    void set_zoom(double in_zoom)
+    {
+      set_zoom(in_zoom, m_window_width / 2.0, m_window_height / 2.0);
+    }
+    // -------------------------------------------------------------------------
+    // get_zoom_best_fit
+    // -------------------------------------------------------------------------
+    bool get_zoom_best_fit() const
+    {
+      return m_zoom_best_fit;
+    }
+    // -------------------------------------------------------------------------
+    // set_zoom_best_fit
+    // -------------------------------------------------------------------------
+    void set_zoom_best_fit(bool in_enable)
+    {
+      m_zoom_best_fit = in_enable;
+      if (m_zoom_best_fit == false)
+        return;
+      adjust_zoom_best_fit();
+    }
+    // -------------------------------------------------------------------------
+    // get_window_level
+    // -------------------------------------------------------------------------
+    // Retrieves the window/level used to display the monochrome image (the
+    // override or the setting of the pixel format). Returns false if the
+    // image is not monochrome
+    //
+    bool get_window_level(double *out_window, double *out_level)
+    {
+      if (m_image_data_ptr == nullptr || m_image_data_ptr->is_mono() == false)
+        return false;
+      if (m_image_data_ptr->get_display_window_level(out_window, out_level))
+        return true;
+      switch (m_image_data_ptr->get_pixel_format())
+      {
+        case Data::PIXEL_FORMAT_MONO16:
+        {
+          int window, level;
+          m_image_data_ptr->get_window_level(&window, &level);
+          *out_window = window;
+          *out_level = level;
+          break;
+        }
+        case Data::PIXEL_FORMAT_MONO32F:
+        {
+          // The auto-range may be being updated by the conversion thread :
+          // the range of the presented image is used (no wait on the UI thread)
+          double min_v = m_float_min;
+          double max_v = m_float_max;
+          if (m_image_data_ptr->is_async_conversion_enabled())
+          {
+            min_v = m_presented_float_min;
+            max_v = m_presented_float_max;
+          }
+          *out_window = max_v - min_v;
+          *out_level = (max_v + min_v) / 2;
+          break;
+        }
+        default:
+          *out_window = 256;
+          *out_level = 128;
+          break;
+      }
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // set_window_level
+    // -------------------------------------------------------------------------
+    // Overrides the window/level of the monochrome image for display
+    // (see Data::set_display_window_level()). The current frame is mapped
+    // again by the next draw
+    //
+    void set_window_level(double in_window, double in_level)
+    {
+      if (m_image_data_ptr == nullptr)
+        return;
+      m_image_data_ptr->set_display_window_level(in_window, in_level);
+      invoke_window_level_updated_handlers();
+      queue_draw();
+    }
+    // -------------------------------------------------------------------------
+    // reset_window_level
+    // -------------------------------------------------------------------------
+    void reset_window_level()
+    {
+      if (m_image_data_ptr == nullptr)
+        return;
+      m_image_data_ptr->reset_display_window_level();
+      invoke_window_level_updated_handlers();
+      queue_draw();
+    }
+    // -------------------------------------------------------------------------
+    // set_zoom
+    // -------------------------------------------------------------------------
+    void set_zoom(double in_zoom, double in_x, double in_y)
+    {
+      double v;
+      double prev_zoom = m_zoom;
+      m_zoom = in_zoom;
+
+      if (fabs(m_zoom - 1.0) <= 0.01)
+        m_zoom = 1.0;
+      if (m_zoom <= 0.01)
+        m_zoom = 0.01;
+
+      double prev_width = m_width;
+      double prev_height = m_height;
+      v = m_org_width * m_zoom;
+      m_width = v;
+      v = m_org_height * m_zoom;
+      m_height = v;
+
+      if (m_width <= m_window_width)
+        m_offset_x = 0;
+      else
+      {
+        if (prev_width <= m_window_width)
+          v = -1 * (m_window_width - prev_width) / 2.0;
+        else
+          v = 0;
+        v = (in_x + m_offset_x + v) / prev_zoom;
+        v = v * m_zoom - in_x;
+        m_offset_x = v;
+        m_offset_x_max = m_width - m_window_width;
+        if (m_offset_x > m_offset_x_max)
+          m_offset_x = m_offset_x_max;
+        if (m_offset_x < 0)
+          m_offset_x = 0;
+      }
+      configure_h_adjustment(); // calling here is important
+
+      if (m_height <= m_window_height)
+        m_offset_y = 0;
+      else
+      {
+        if (prev_height <= m_window_height)
+          v = -1 * (m_window_height - prev_height) / 2.0;
+        else
+          v = 0;
+        v = (in_y + m_offset_y + v) / prev_zoom;
+        v = v * m_zoom - in_y;
+        m_offset_y = v;
+        m_offset_y_max = m_height - m_window_height;
+        if (m_offset_y > m_offset_y_max)
+          m_offset_y = m_offset_y_max;
+        if (m_offset_y < 0)
+          m_offset_y = 0;
+      }
+      configure_v_adjustment();
+      queue_draw();
+      invoke_zoom_updated_handlers();
+    }
+    // -------------------------------------------------------------------------
+    // update_pixbuf
+    // -------------------------------------------------------------------------
+    bool update_pixbuf()
+    {
+      if (m_image_data_ptr == nullptr)
+        return false;
+      bool is_async = m_image_data_ptr->is_async_conversion_enabled();
+      if (m_is_async_job_posted)
+      {
+        // The newest frame is taken when the running conversion is finished
+        if (is_async && m_conversion_thread.is_busy())
+          return true;
+        present_async_result();
+      }
+      m_image_data_ptr->acquire_submitted_buffer();
+      m_image_data_ptr->acquire_latest_frame();
+      if (m_image_data_ptr->is_valid() == false)
+        return false;
+      bool need_to_create = true;
+      if (m_pixbuf || m_surface)
+      {
+        if (m_org_width == m_image_data_ptr->get_width() &&
+            m_org_height == m_image_data_ptr->get_height() &&
+            m_pixel_format == m_image_data_ptr->get_pixel_format())
+          need_to_create = false;
+      }
+      if (need_to_create)
+      {
+        m_pixel_format = m_image_data_ptr->get_pixel_format();
+        m_org_width = m_image_data_ptr->get_width();
+        m_org_height = m_image_data_ptr->get_height();
+        m_width = m_org_width;
+        m_height = m_org_height;
+        configure_h_adjustment();
+        configure_v_adjustment();
+        m_pixbuf.reset();
+        m_surface.reset();
+        invalidate_mipmaps();
+        if (is_surface_format(m_pixel_format) == false)
+        {
+          m_pixbuf = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, false, 8,
+                                         m_image_data_ptr->get_width(),
+                                         m_image_data_ptr->get_height());
+          if (!m_pixbuf)
+            return false;
+        }
+        else if (update_surface() == false)
+          return false;
+        invoke_image_info_updated_handlers();
+      } else
+      {
+        if (m_image_data_ptr->is_modified() == false)
+        {
+          // Panning or zooming may show the region not converted yet
+          if (is_async)
+            start_async_rescale();
+          else if (m_image_data_ptr->is_viewport_conversion_enabled())
+          {
+            convert_visible_region();
+            invalidate_zoomed_image();
+          }
+          return true;
+        }
+        if (is_surface_format(m_pixel_format) && update_surface() == false)
+          return false;
+      }
+      if (m_image_data_ptr->get_frame_counter() == 0)
+      {
+        m_fps_counter.start_count();
+        m_fps = 0;
+        m_fps_sum_counter.start_count();
+        m_fps_sum = 0;
+        m_fps_sum_num = 0;
+      }
+      else
+      {
+        double v;
+        v = (double )m_fps_counter.elapsed_time();
+        m_fps_counter.start_count();
+        if (v != 0)
+          v = 1000000000.0 / v;
+        m_fps_sum += v;
+        m_fps_sum_num++;
+        if (m_fps_sum_counter.elapsed_time() > 1000000000)
+        {
+          m_fps = m_fps_sum / m_fps_sum_num;
+          m_fps_sum_counter.start_count();
+          m_fps_sum = 0;
+          m_fps_sum_num = 0;
+        }
+      }
+      update_mouse_info();
+      m_image_data_ptr->mark_as_displayed();
+      invoke_frame_info_updated_handlers(true, m_fps);
+      bool is_partial = m_image_data_ptr->take_modified_regions(&m_modified_regions);
+      if (is_async)
+      {
+        m_modified_regions.clear();
+        start_async_conversion();
+      }
+      else if (prepare_conversion() || need_to_create || is_partial == false)
+      {
+        clear_converted_region();
+        invalidate_mipmaps();
+        if (m_image_data_ptr->is_viewport_conversion_enabled())
+          convert_visible_region();
+        else
+          convert_whole_image();
+      }
+      else
+        convert_modified_regions();
+      invalidate_zoomed_image();
+      m_image_data_ptr->release_retired_buffer();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // start_async_conversion
+    // -------------------------------------------------------------------------
+    // Converts the current frame on the conversion thread. The thread owns
+    // the pixbuf, the surface and the downscale pyramid until the result is
+    // presented by present_async_result() on the UI thread
+    //
+    void start_async_conversion()
+    {
+      prepare_async_targets();
+      double zoom = m_zoom;
+      m_is_async_job_posted = m_conversion_thread.post([this, zoom]
+      {
+        prepare_conversion();
+        clear_converted_region();
+        invalidate_mipmaps();
+        convert_whole_image();
+        if (zoom < 1)
+          get_scaled_image(zoom);
+        m_async_dispatcher.emit();
+      });
     }
     // -------------------------------------------------------------------------
-    // set_zoom_best_fit
+    // start_async_rescale
     // -------------------------------------------------------------------------
-    void set_zoom_best_fit(bool in_enable)
+    // Resamples the presented image for the new zoom (< 1) on the conversion
+    // thread. The converted image is only read by both of the threads
+    //
+    void start_async_rescale()
     {
-      m_zoom_best_fit = in_enable;
-      if (m_zoom_best_fit == false)
+      if (m_zoom >= 1 || is_presented_scaled_valid() ||
+          (!m_presented_surface && !m_presented_pixbuf))
         return;
-      adjust_zoom_best_fit();
+      double zoom = m_zoom;
+      m_is_async_job_posted = m_conversion_thread.post([this, zoom]
+      {
+        get_scaled_image(zoom);
+        m_async_dispatcher.emit();
+      });
+    }
+    // -------------------------------------------------------------------------
+    // prepare_async_targets
+    // -------------------------------------------------------------------------
+    // The conversion does not write to the presented image : the spare one
+    // (the image presented before) is used instead
+    //
+    void prepare_async_targets()
+    {
+      if (m_surface && m_surface == m_presented_surface)
+      {
+        int width = m_surface->get_width();
+        int height = m_surface->get_height();
+        if (!m_spare_surface ||
+            m_spare_surface->get_width() != width || m_spare_surface->get_height() != height)
+          m_spare_surface = Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, width, height);
+        m_surface = m_spare_surface;
+        m_spare_surface = Cairo::RefPtr<Cairo::ImageSurface>();
+      }
+      if (m_pixbuf && m_pixbuf == m_presented_pixbuf)
+      {
+        int width = m_pixbuf->get_width();
+        int height = m_pixbuf->get_height();
+        if (!m_spare_pixbuf ||
+            m_spare_pixbuf->get_width() != width || m_spare_pixbuf->get_height() != height)
+          m_spare_pixbuf = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, false, 8, width, height);
+        m_pixbuf = m_spare_pixbuf;
+        m_spare_pixbuf.reset();
+      }
+    }
+    // -------------------------------------------------------------------------
+    // present_async_result
+    // -------------------------------------------------------------------------
+    // Waits for the conversion thread and makes its result the presented image
+    //
+    void present_async_result()
+    {
+      m_conversion_thread.wait();
+      if (m_is_async_job_posted == false)
+        return;
+      m_is_async_job_posted = false;
+      m_presented_float_min = m_float_min;
+      m_presented_float_max = m_float_max;
+      if (m_presented_surface != m_surface)
+      {
+        m_spare_surface = m_presented_surface;
+        m_presented_surface = m_surface;
+      }
+      if (m_presented_pixbuf != m_pixbuf)
+      {
+        m_spare_pixbuf = m_presented_pixbuf;
+        m_presented_pixbuf = m_pixbuf;
+      }
+      m_presented_scaled_image = m_scaled_image;
+      invalidate_zoomed_image();
+    }
+    // -------------------------------------------------------------------------
+    // is_presented_scaled_valid
+    // -------------------------------------------------------------------------
+    bool is_presented_scaled_valid()
+    {
+      if (!m_presented_scaled_image)
+        return false;
+      return (m_presented_scaled_image->get_width() ==
+                      std::max(1, (int )lround(m_org_width * m_zoom)) &&
+              m_presented_scaled_image->get_height() ==
+                      std::max(1, (int )lround(m_org_height * m_zoom)));
+    }
+    // -------------------------------------------------------------------------
+    // on_async_conversion_done
+    // -------------------------------------------------------------------------
+    void on_async_conversion_done()
+    {
+      present_async_result();
+      queue_draw();
+    }
+    // -------------------------------------------------------------------------
+    // is_surface_format
+    // -------------------------------------------------------------------------
+    // The 4 byte formats, BGR8 and YUV are rendered through a Cairo image surface
+    // in the native Cairo layout instead of the RGB8 pixbuf
+    //
+    static bool is_surface_format(Data::PixelFormat in_format)
+    {
+      switch (in_format)
+      {
+        case Data::PIXEL_FORMAT_BGRA8:
+        case Data::PIXEL_FORMAT_RGBA8:
+        case Data::PIXEL_FORMAT_BGR8:
+        case Data::PIXEL_FORMAT_YUYV:
+        case Data::PIXEL_FORMAT_UYVY:
+        case Data::PIXEL_FORMAT_NV12:
+        case Data::PIXEL_FORMAT_I420:
+          return true;
+        default:
+          break;
+      }
+      return false;
+    }
+    // -------------------------------------------------------------------------
+    // update_surface
+    // -------------------------------------------------------------------------
+    // BGRA8 is the native layout of Cairo::FORMAT_RGB24 on little endian
+    // machines, so the image buffer is wrapped directly (zero copy).
+    // The other formats are converted into a surface owned by the view
+    //
+    bool update_surface()
+    {
+      uint8_t *image = m_image_data_ptr->get_image();
+      int width = m_image_data_ptr->get_width();
+      int height = m_image_data_ptr->get_height();
+      size_t stride = m_image_data_ptr->get_stride();
+      // The asynchronous conversion paints the image while the next frame is
+      // written to the buffer, so it is never wrapped
+      bool can_wrap = (m_image_data_ptr->get_pixel_format() == Data::PIXEL_FORMAT_BGRA8 &&
+                       (stride % 4) == 0 &&
+                       m_image_data_ptr->is_async_conversion_enabled() == false);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+      can_wrap = false;
+#endif
+      if (can_wrap)
+      {
+        if (!m_surface || m_is_surface_wrapped == false ||
+            m_surface->get_data() != image ||
+            m_surface->get_width() != width || m_surface->get_height() != height ||
+            (size_t )m_surface->get_stride() != stride)
+        {
+          m_surface = Cairo::ImageSurface::create(image, Cairo::FORMAT_RGB24,
+                                                  width, height, (int )stride);
+        }
+        m_is_surface_wrapped = true;
+        return (bool )m_surface;
+      }
+      if (!m_surface || m_is_surface_wrapped ||
+          m_surface->get_width() != width || m_surface->get_height() != height)
+      {
+        m_surface = Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, width, height);
+      }
+      m_is_surface_wrapped = false;
+      if (!m_surface)
+        return false;
+      m_surface->flush();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // prepare_conversion
+    // -------------------------------------------------------------------------
+    // Updates the tables used by convert_rows() for the current frame.
+    // Returns true if the tables are changed (the whole image needs to be
+    // converted again)
+    //
+    bool prepare_conversion()
+    {
+      bool is_changed = false;
+      if (m_image_data_ptr->is_mono() &&
+          m_colormap_index != m_image_data_ptr->get_colormap_index())
+      {
+        is_changed = true;
+        m_colormap_index = m_image_data_ptr->get_colormap_index();
+        m_colormap_lut = Colormap::get_shared_colormap(m_colormap_index,
+                                                       IM_VIEW_COLORMAP_COLOR_NUM);
+        m_colormap = m_colormap_lut.get();
+        m_is_colormap32_valid = false;
+      }
+      // The display window/level override replaces the setting of each format
+      double display_window, display_level;
+      bool is_display_window_level =
+              m_image_data_ptr->get_display_window_level(&display_window, &display_level);
+      switch (m_image_data_ptr->get_pixel_format())
+      {
+        case Data::PIXEL_FORMAT_MONO8:
+        {
+          int window = 256, level = 128;
+          if (is_display_window_level)
+            to_int_window_level(display_window, display_level, &window, &level);
+          if (m_is_colormap32_valid == false ||
+              m_mono8_lut_window != window || m_mono8_lut_level != level)
+          {
+            // The window/level is folded into the packed colormap
+            uint8_t index_lut[IM_VIEW_COLORMAP_COLOR_NUM];
+            Converter::make_window_level_lut(window, level, index_lut,
+                                             IM_VIEW_COLORMAP_COLOR_NUM);
+            Converter::make_rgb_lut32(m_colormap, index_lut, m_colormap32);
+            m_is_colormap32_valid = true;
+            m_mono8_lut_window = window;
+            m_mono8_lut_level = level;
+            is_changed = true;
+          }
+          break;
+        }
+        case Data::PIXEL_FORMAT_MONO16:
+        {
+          int window, level;
+          m_image_data_ptr->get_window_level(&window, &level);
+          if (is_display_window_level)
+            to_int_window_level(display_window, display_level, &window, &level);
+          if (m_mono16_lut.empty() ||
+              m_mono16_lut_window != window || m_mono16_lut_level != level)
+          {
+            m_mono16_lut.resize(Converter::MONO16_LUT_SIZE);
+            Converter::make_window_level_lut(window, level, m_mono16_lut.data());
+            m_mono16_lut_window = window;
+            m_mono16_lut_level = level;
+            is_changed = true;
+          }
+          break;
+        }
+        case Data::PIXEL_FORMAT_MONO32F:
+        {
+          double prev_min = m_float_min;
+          double prev_max = m_float_max;
+          if (is_display_window_level)
+          {
+            m_float_min = display_level - display_window / 2;
+            m_float_max = display_level + display_window / 2;
+            is_changed = (m_float_min != prev_min || m_float_max != prev_max);
+            break;
+          }
+          if (m_image_data_ptr->get_float_range(&m_float_min, &m_float_max) == false)
+          {
+            is_changed = (m_float_min != prev_min || m_float_max != prev_max);
+            break;
+          }
+          // Auto-range : combine the range of the finite values in each row
+          const uint8_t *src = m_image_data_ptr->get_image();
+          size_t stride = m_image_data_ptr->get_stride();
+          int width = m_image_data_ptr->get_width();
+          int height = m_image_data_ptr->get_height();
+          float min_v = FLT_MAX, max_v = -FLT_MAX;
+          for (int y = 0; y < height; y++)
+          {
+            float row_min, row_max;
+            if (Converter::mono32f_min_max((const float *)(src + y * stride), width,
+                                           &row_min, &row_max) == false)
+              continue;
+            if (row_min < min_v)
+              min_v = row_min;
+            if (row_max > max_v)
+              max_v = row_max;
+          }
+          if (min_v <= max_v)
+          {
+            m_float_min = min_v;
+            m_float_max = max_v;
+          }
+          is_changed = (m_float_min != prev_min || m_float_max != prev_max);
+          break;
+        }
+        default:
+          break;
+      }
+      return is_changed;
+    }
+    // -------------------------------------------------------------------------
+    // to_int_window_level
+    // -------------------------------------------------------------------------
+    // Rounds the display window/level for the integer formats. The values are
+    // clamped well outside of the 16bit range to keep the LUT math in range
+    //
+    static void to_int_window_level(double in_window, double in_level,
+                                    int *out_window, int *out_level)
+    {
+      const double limit = (double )(1 << 24);
+      *out_window = (int )std::round(std::min(std::max(in_window, 1.0), limit));
+      *out_level = (int )std::round(std::min(std::max(in_level, -limit), limit));
+    }
+    // -------------------------------------------------------------------------
+    // convert_region
+    // -------------------------------------------------------------------------
+    // Converts the region [in_x_start, in_x_end) x [in_y_start, in_y_end).
+    // The large regions are split into the row bands converted by the worker
+    // pool. The small ones are converted on the UI thread only
+    //
+    void convert_region(int in_x_start, int in_y_start, int in_x_end, int in_y_end)
+    {
+      if (in_x_end <= in_x_start)
+        return;
+      run_row_bands(in_y_start, in_y_end, in_x_end - in_x_start,
+                    [this, in_x_start, in_x_end](int in_y0, int in_y1)
+      {
+        convert_rows(in_y0, in_y1, in_x_start, in_x_end);
+      });
+    }
+    // -------------------------------------------------------------------------
+    // run_row_bands
+    // -------------------------------------------------------------------------
+    // Calls in_func(y0, y1) for the row bands of [in_y_start, in_y_end) on the
+    // worker pool. The small regions (in_width x rows) are done in one call on
+    // the calling thread
+    //
+    static void run_row_bands(int in_y_start, int in_y_end, int in_width,
+                              const std::function<void(int, int)> &in_func)
+    {
+      int rows = in_y_end - in_y_start;
+      if (rows <= 0)
+        return;
+      size_t pixel_num = (size_t )in_width * rows;
+      base::WorkerPool *pool = base::BackgroundApp::get_worker_pool();
+      int thread_num = base::BackgroundApp::get_worker_thread_num();
+      if (pool == nullptr || thread_num <= 1 || pixel_num < IM_VIEW_PARALLEL_MIN_PIXEL_NUM)
+      {
+        in_func(in_y_start, in_y_end);
+        return;
+      }
+      // A few bands per thread balance the load
+      int band_num = thread_num * 4;
+      if (band_num > rows)
+        band_num = rows;
+      pool->run(band_num, thread_num, [&in_func, in_y_start, rows, band_num](int in_band)
+      {
+        in_func(in_y_start + (int )((int64_t )rows * in_band / band_num),
+                in_y_start + (int )((int64_t )rows * (in_band + 1) / band_num));
+      });
+    }
+    // -------------------------------------------------------------------------
+    // expand_modified_region
+    // -------------------------------------------------------------------------
+    // Expands the modified region of the image data to the converted pixels
+    // depending on it (the interpolation of the Bayer formats and the shared
+    // chroma samples of the YUV formats)
+    //
+    void expand_modified_region(int *io_x_start, int *io_y_start, int *io_x_end, int *io_y_end)
+    {
+      switch (m_image_data_ptr->get_pixel_format())
+      {
+        case Data::PIXEL_FORMAT_BAYER_RG8:
+        case Data::PIXEL_FORMAT_BAYER_GB8:
+        case Data::PIXEL_FORMAT_BAYER_GR8:
+        case Data::PIXEL_FORMAT_BAYER_BG8:
+          // convert_rows() converts the Bayer formats in the full width
+          *io_x_start = 0;
+          *io_x_end = (int )m_org_width;
+          *io_y_start -= 1;
+          *io_y_end += 1;
+          break;
+        case Data::PIXEL_FORMAT_NV12:
+        case Data::PIXEL_FORMAT_I420:
+          *io_y_start &= ~1;
+          *io_y_end = (*io_y_end + 1) & ~1;
+          // fall through
+        case Data::PIXEL_FORMAT_YUYV:
+        case Data::PIXEL_FORMAT_UYVY:
+          *io_x_start &= ~1;
+          *io_x_end = (*io_x_end + 1) & ~1;
+          break;
+        default:
+          break;
+      }
+      *io_x_start = std::max(*io_x_start, 0);
+      *io_y_start = std::max(*io_y_start, 0);
+      *io_x_end = std::min(*io_x_end, (int )m_org_width);
+      *io_y_end = std::min(*io_y_end, (int )m_org_height);
+    }
+    // -------------------------------------------------------------------------
+    // convert_modified_regions
+    // -------------------------------------------------------------------------
+    // Converts only the regions marked by Data::mark_region_modified(). The
+    // parts outside of the converted region are left to the viewport
+    // conversion
+    //
+    void convert_modified_regions()
+    {
+      for (const Data::Region &region : m_modified_regions)
+      {
+        int x0 = region.x;
+        int y0 = region.y;
+        int x1 = region.x + region.width;
+        int y1 = region.y + region.height;
+        expand_modified_region(&x0, &y0, &x1, &y1);
+        x0 = std::max(x0, m_converted_x_start);
+        y0 = std::max(y0, m_converted_y_start);
+        x1 = std::min(x1, m_converted_x_end);
+        y1 = std::min(y1, m_converted_y_end);
+        if (x0 >= x1 || y0 >= y1)
+          continue;
+        convert_region(x0, y0, x1, y1);
+        if (m_surface)
+          m_surface->mark_dirty(x0, y0, x1 - x0, y1 - y0);
+        update_mipmap_region(x0, y0, x1, y1);
+      }
+      m_modified_regions.clear();
+    }
+    // -------------------------------------------------------------------------
+    // queue_draw_modified
+    // -------------------------------------------------------------------------
+    // Called for the updates of the image data. In the frame clock pacing mode
+    // the redraw is left to on_frame_tick()
+    //
+    void queue_draw_modified()
+    {
+      if (m_image_data_ptr != nullptr && m_image_data_ptr->is_frame_clock_pacing_enabled())
+      {
+        start_frame_tick();
+        return;
+      }
+      queue_draw_regions();
+    }
+    // -------------------------------------------------------------------------
+    // start_frame_tick
+    // -------------------------------------------------------------------------
+    void start_frame_tick()
+    {
+      if (m_frame_tick_id != 0)
+        return;
+      m_frame_tick_id = add_tick_callback(sigc::mem_fun(
+              *this, &shl::gtk::image::View::on_frame_tick));
+      m_image_data_ptr->set_frame_tick_running(m_frame_tick_id != 0);
+    }
+    // -------------------------------------------------------------------------
+    // stop_frame_tick
+    // -------------------------------------------------------------------------
+    void stop_frame_tick()
+    {
+      if (m_frame_tick_id != 0)
+      {
+        remove_tick_callback(m_frame_tick_id);
+        m_frame_tick_id = 0;
+      }
+      if (m_image_data_ptr != nullptr)
+        m_image_data_ptr->set_frame_tick_running(false);
+    }
+    // -------------------------------------------------------------------------
+    // on_frame_tick
+    // -------------------------------------------------------------------------
+    // Called once per frame of the display. At most one redraw is queued for
+    // each frame and the redraw presents the newest frame of the image data
+    // (the frames updated in between are skipped)
+    //
+    bool on_frame_tick(const Glib::RefPtr<Gdk::FrameClock> & /* in_frame_clock */)
+    {
+      if (m_image_data_ptr == nullptr ||
+          m_image_data_ptr->is_frame_clock_pacing_enabled() == false)
+      {
+        // Returning false removes the tick callback
+        m_frame_tick_id = 0;
+        if (m_image_data_ptr != nullptr)
+          m_image_data_ptr->set_frame_tick_running(false);
+        return false;
+      }
+      if (m_image_data_ptr->stop_frame_tick_if_idle())
+      {
+        // Nothing was updated for a frame : the callback is removed until
+        // queue_draw_modified() is called by the next update()
+        m_frame_tick_id = 0;
+        return false;
+      }
+      queue_draw_regions();
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // queue_draw_regions
+    // -------------------------------------------------------------------------
+    // Queues the redraw of the widget area showing the modified regions of the
+    // image data (the whole widget if the whole image is modified)
+    //
+    void queue_draw_regions()
+    {
+      if (m_image_data_ptr == nullptr ||
+          (!m_pixbuf && !m_surface) ||
+          m_image_data_ptr->get_width() != (int )m_org_width ||
+          m_image_data_ptr->get_height() != (int )m_org_height ||
+          m_image_data_ptr->get_pixel_format() != m_pixel_format ||
+          m_image_data_ptr->is_new_frame_pending() ||
+          m_image_data_ptr->is_async_conversion_enabled() ||
+          m_image_data_ptr->get_modified_regions(&m_queued_regions) == false ||
+          m_queued_regions.empty())
+      {
+        queue_draw();
+        return;
+      }
+      double x, y;
+      get_image_position(&x, &y);
+      for (const Data::Region &region : m_queued_regions)
+      {
+        int x0 = region.x;
+        int y0 = region.y;
+        int x1 = region.x + region.width;
+        int y1 = region.y + region.height;
+        expand_modified_region(&x0, &y0, &x1, &y1);
+        // 1 pixel margin for the rounding and the area average of zoom < 1
+        int wx0 = (int )floor(x + x0 * m_zoom) - 1;
+        int wy0 = (int )floor(y + y0 * m_zoom) - 1;
+        int wx1 = (int )ceil(x + x1 * m_zoom) + 1;
+        int wy1 = (int )ceil(y + y1 * m_zoom) + 1;
+        wx0 = std::max(wx0, 0);
+        wy0 = std::max(wy0, 0);
+        wx1 = std::min(wx1, (int )ceil(m_window_width));
+        wy1 = std::min(wy1, (int )ceil(m_window_height));
+        if (wx0 < wx1 && wy0 < wy1)
+          queue_draw_area(wx0, wy0, wx1 - wx0, wy1 - wy0);
+      }
+    }
+    // -------------------------------------------------------------------------
+    // get_image_position
+    // -------------------------------------------------------------------------
+    // The position of the top-left of the image in the widget
+    //
+    void get_image_position(double *out_x, double *out_y)
+    {
+      if (m_width <= m_window_width)
+        *out_x = (m_window_width - m_width) / 2;
+      else
+        *out_x = -1 * m_offset_x;
+      if (m_height <= m_window_height)
+        *out_y = (m_window_height - m_height) / 2;
+      else
+        *out_y = -1 * m_offset_y;
+    }
+    // -------------------------------------------------------------------------
+    // get_visible_region
+    // -------------------------------------------------------------------------
+    // Calculates the image region shown in the window (same placement as
+    // on_draw())
+    //
+    void get_visible_region(int *out_x_start, int *out_y_start, int *out_x_end, int *out_y_end)
+    {
+      double x, y;
+      get_image_position(&x, &y);
+      *out_x_start = std::max(0, (int )floor(-x / m_zoom));
+      *out_y_start = std::max(0, (int )floor(-y / m_zoom));
+      *out_x_end = std::min((int )m_org_width, (int )ceil((m_window_width - x) / m_zoom));
+      *out_y_end = std::min((int )m_org_height, (int )ceil((m_window_height - y) / m_zoom));
+    }
+    // -------------------------------------------------------------------------
+    // convert_visible_region
+    // -------------------------------------------------------------------------
+    // Viewport conversion : converts the visible region (with a margin for
+    // the panning) if it is not converted yet for the current frame
+    //
+    void convert_visible_region()
+    {
+      int x0, y0, x1, y1;
+      get_visible_region(&x0, &y0, &x1, &y1);
+      if (x0 >= x1 || y0 >= y1)
+        return;
+      if (x0 >= m_converted_x_start && y0 >= m_converted_y_start &&
+          x1 <= m_converted_x_end && y1 <= m_converted_y_end)
+        return;
+      int margin_x = (x1 - x0) / 4 + 1;
+      int margin_y = (y1 - y0) / 4 + 1;
+      x0 = std::max(0, x0 - margin_x);
+      y0 = std::max(0, y0 - margin_y);
+      x1 = std::min((int )m_org_width, x1 + margin_x);
+      y1 = std::min((int )m_org_height, y1 + margin_y);
+      convert_region(x0, y0, x1, y1);
+      if (m_surface)
+        m_surface->mark_dirty();
+      invalidate_mipmaps();
+      m_converted_x_start = x0;
+      m_converted_y_start = y0;
+      m_converted_x_end = x1;
+      m_converted_y_end = y1;
+    }
+    // -------------------------------------------------------------------------
+    // convert_whole_image
+    // -------------------------------------------------------------------------
+    void convert_whole_image()
+    {
+      int width = (int )m_org_width;
+      int height = (int )m_org_height;
+      if (m_converted_x_start == 0 && m_converted_y_start == 0 &&
+          m_converted_x_end == width && m_converted_y_end == height)
+        return;
+      convert_region(0, 0, width, height);
+      if (m_surface)
+        m_surface->mark_dirty();
+      invalidate_mipmaps();
+      m_converted_x_start = 0;
+      m_converted_y_start = 0;
+      m_converted_x_end = width;
+      m_converted_y_end = height;
+    }
+    // -------------------------------------------------------------------------
+    // clear_converted_region
+    // -------------------------------------------------------------------------
+    void clear_converted_region()
+    {
+      m_converted_x_start = 0;
+      m_converted_y_start = 0;
+      m_converted_x_end = 0;
+      m_converted_y_end = 0;
+    }
+    // -------------------------------------------------------------------------
+    // get_scaled_image
+    // -------------------------------------------------------------------------
+    // Returns the image downscaled to in_zoom (< 1) by the area average. The
+    // nearest pyramid level that is not smaller than the display size is
+    // resampled to the exact size, so every source pixel is weighted by its
+    // covered area (no aliasing nor the bilinear blur of the Cairo filter).
+    // The result is kept until the converted image or the zoom changes
+    //
+    Cairo::RefPtr<Cairo::ImageSurface> get_scaled_image(double in_zoom)
+    {
+      int width = std::max(1, (int )lround(m_org_width * in_zoom));
+      int height = std::max(1, (int )lround(m_org_height * in_zoom));
+      if (m_scaled_image &&
+          m_scaled_image->get_width() == width && m_scaled_image->get_height() == height)
+        return m_scaled_image;
+      int level = 0;
+      int level_width = (int )m_org_width;
+      int level_height = (int )m_org_height;
+      while (level_width / 2 >= width && level_height / 2 >= height)
+      {
+        level_width /= 2;
+        level_height /= 2;
+        level++;
+      }
+      while ((int )m_mipmaps.size() < level)
+      {
+        Cairo::RefPtr<Cairo::ImageSurface> next = build_mipmap_level();
+        if (!next)
+          return Cairo::RefPtr<Cairo::ImageSurface>();
+        m_mipmaps.push_back(next);
+      }
+      if (level != 0 && level_width == width && level_height == height)
+      {
+        // Power of two : the pyramid level itself
+        m_scaled_image = m_mipmaps[level - 1];
+        m_scaled_level = -1;
+        return m_scaled_image;
+      }
+      m_scaled_image = Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, width, height);
+      if (!m_scaled_image)
+        return m_scaled_image;
+      m_scaled_level = level;
+      Converter::make_area_weights(level_width, width, &m_scaled_weights_x);
+      Converter::make_area_weights(level_height, height, &m_scaled_weights_y);
+      if (resample_scaled_rows(0, height) == false)
+        m_scaled_image = Cairo::RefPtr<Cairo::ImageSurface>();
+      return m_scaled_image;
+    }
+    // -------------------------------------------------------------------------
+    // resample_scaled_rows
+    // -------------------------------------------------------------------------
+    // Area-averages the rows [in_y_start, in_y_end) of m_scaled_image from
+    // the pyramid level m_scaled_level
+    //
+    bool resample_scaled_rows(int in_y_start, int in_y_end)
+    {
+      const uint8_t *src;
+      size_t src_stride, src_pixel_size;
+      int src_width, src_height;
+      if (get_mipmap_source(m_scaled_level, &src, &src_stride, &src_pixel_size,
+                            &src_width, &src_height) == false)
+        return false;
+      m_scaled_image->flush();
+      uint8_t *dst = m_scaled_image->get_data();
+      size_t dst_stride = m_scaled_image->get_stride();
+      int width = m_scaled_image->get_width();
+      const Converter::AreaWeights &weights_x = m_scaled_weights_x;
+      const Converter::AreaWeights &weights_y = m_scaled_weights_y;
+      run_row_bands(in_y_start, in_y_end, src_width,
+                    [&](int in_y0, int in_y1)
+      {
+        std::vector<float> row((size_t )width * 4);
+        std::vector<float> acc((size_t )width * 4);
+        for (int y = in_y0; y < in_y1; y++)
+        {
+          std::fill(acc.begin(), acc.end(), 0.0f);
+          const float *w = &(weights_y.weights[(size_t )y * weights_y.tap_num]);
+          for (int t = 0; t < weights_y.count[y]; t++)
+          {
+            Converter::area_downscale_row(src + (size_t )(weights_y.start[y] + t) * src_stride,
+                                          src_pixel_size, weights_x, row.data(), width);
+            Converter::accumulate_row(row.data(), w[t], acc.data(), acc.size());
+          }
+          Converter::store_rgb24_row(acc.data(), dst + y * dst_stride, width);
+        }
+      });
+      m_scaled_image->mark_dirty(0, in_y_start, width, in_y_end - in_y_start);
+      return true;
+    }
+    // -------------------------------------------------------------------------
+    // get_mipmap_source
+    // -------------------------------------------------------------------------
+    // The pixels of the pyramid level in_level (0 is the converted image)
+    //
+    bool get_mipmap_source(int in_level, const uint8_t **out_src, size_t *out_stride,
+                           size_t *out_pixel_size, int *out_width, int *out_height)
+    {
+      Cairo::RefPtr<Cairo::ImageSurface> surface;
+      if (in_level > 0)
+        surface = m_mipmaps[in_level - 1];
+      else
+        surface = m_surface;
+      if (surface)
+      {
+        surface->flush();
+        *out_src = surface->get_data();
+        *out_stride = surface->get_stride();
+        *out_pixel_size = 4;
+        *out_width = surface->get_width();
+        *out_height = surface->get_height();
+        return true;
+      }
+      if (m_pixbuf)
+      {
+        *out_src = m_pixbuf->get_pixels();
+        *out_stride = m_pixbuf->get_rowstride();
+        *out_pixel_size = 3;
+        *out_width = m_pixbuf->get_width();
+        *out_height = m_pixbuf->get_height();
+        return true;
+      }
+      return false;
+    }
+    // -------------------------------------------------------------------------
+    // build_mipmap_level
+    // -------------------------------------------------------------------------
+    // Builds the next level of the downscale pyramid (1/2 of the last level).
+    // The level n is 1/2^n of the image
+    //
+    Cairo::RefPtr<Cairo::ImageSurface> build_mipmap_level()
+    {
+      const uint8_t *src;
+      size_t src_stride, src_pixel_size;
+      int src_width, src_height;
+      if (get_mipmap_source((int )m_mipmaps.size(), &src, &src_stride, &src_pixel_size,
+                            &src_width, &src_height) == false)
+        return Cairo::RefPtr<Cairo::ImageSurface>();
+      int width = src_width / 2;
+      int height = src_height / 2;
+      if (width < 1 || height < 1)
+        return Cairo::RefPtr<Cairo::ImageSurface>();
+      Cairo::RefPtr<Cairo::ImageSurface> level =
+              Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, width, height);
+      uint8_t *dst = level->get_data();
+      size_t dst_stride = level->get_stride();
+      run_row_bands(0, height, src_width,
+                    [src, src_stride, src_pixel_size, dst, dst_stride, width](int in_y0, int in_y1)
+      {
+        for (int y = in_y0; y < in_y1; y++)
+          Converter::downscale_half_to_rgb24(src + (y * 2) * src_stride,
+                                             src + (y * 2 + 1) * src_stride,
+                                             src_pixel_size, dst + y * dst_stride, width);
+      });
+      level->mark_dirty();
+      return level;
+    }
+    // -------------------------------------------------------------------------
+    // update_mipmap_region
+    // -------------------------------------------------------------------------
+    // Updates the pyramid levels and the scaled image for the modified region
+    // [in_x_start, in_x_end) x [in_y_start, in_y_end) of the converted image
+    //
+    void update_mipmap_region(int in_x_start, int in_y_start, int in_x_end, int in_y_end)
+    {
+      for (int n = 0; n <= (int )m_mipmaps.size(); n++)
+      {
+        if (n != 0)
+        {
+          const uint8_t *src;
+          size_t src_stride, src_pixel_size;
+          int src_width, src_height;
+          if (get_mipmap_source(n - 1, &src, &src_stride, &src_pixel_size,
+                                &src_width, &src_height) == false)
+            return;
+          Cairo::RefPtr<Cairo::ImageSurface> &level = m_mipmaps[n - 1];
+          in_x_start /= 2;
+          in_y_start /= 2;
+          in_x_end = std::min(level->get_width(), (in_x_end + 1) / 2);
+          in_y_end = std::min(level->get_height(), (in_y_end + 1) / 2);
+          if (in_x_start >= in_x_end || in_y_start >= in_y_end)
+            return;
+          level->flush();
+          uint8_t *dst = level->get_data() + in_x_start * 4;
+          size_t dst_stride = level->get_stride();
+          src += in_x_start * 2 * src_pixel_size;
+          int num = in_x_end - in_x_start;
+          run_row_bands(in_y_start, in_y_end, num * 2,
+                        [src, src_stride, src_pixel_size, dst, dst_stride, num](int in_y0, int in_y1)
+          {
+            for (int y = in_y0; y < in_y1; y++)
+              Converter::downscale_half_to_rgb24(src + (y * 2) * src_stride,
+                                                 src + (y * 2 + 1) * src_stride,
+                                                 src_pixel_size, dst + y * dst_stride, num);
+          });
+          level->mark_dirty(in_x_start, in_y_start, num, in_y_end - in_y_start);
+        }
+        if (m_scaled_image && n == m_scaled_level)
+        {
+          // The scaled rows covering the modified rows of the level
+          const Converter::AreaWeights &weights_y = m_scaled_weights_y;
+          int height = m_scaled_image->get_height();
+          int y0 = 0;
+          while (y0 < height && weights_y.start[y0] + weights_y.count[y0] <= in_y_start)
+            y0++;
+          int y1 = y0;
+          while (y1 < height && weights_y.start[y1] < in_y_end)
+            y1++;
+          if (resample_scaled_rows(y0, y1) == false)
+            m_scaled_image = Cairo::RefPtr<Cairo::ImageSurface>();
+        }
+      }
+    }
+    // -------------------------------------------------------------------------
+    // invalidate_mipmaps
+    // -------------------------------------------------------------------------
+    void invalidate_mipmaps()
+    {
+      m_mipmaps.clear();
+      m_scaled_image = Cairo::RefPtr<Cairo::ImageSurface>();
     }
     // -------------------------------------------------------------------------
-    // set_zoom
+    // convert_rows
     // -------------------------------------------------------------------------
-    void set_zoom(double in_zoom, double in_x, double in_y)
+    // Converts the rows [in_y_start, in_y_end) (the columns [in_x_start,
+    // in_x_end) of them) of the image data into the pixbuf or the surface.
+    // Both of the source stride and the destination stride are honoured.
+    // The Bayer formats are always converted in the full width
+    //
+    void convert_rows(int in_y_start, int in_y_end, int in_x_start, int in_x_end)
     {
-      double v;
-      double prev_zoom = m_zoom;
-      m_zoom = in_zoom;
-
-      if (fabs(m_zoom - 1.0) <= 0.01)
-        m_zoom = 1.0;
-      if (m_zoom <= 0.01)
-        m_zoom = 0.01;
-
-      double prev_width = m_width;
-      double prev_height = m_height;
-      v = m_org_width * m_zoom;
-      m_width = v;
-      v = m_org_height * m_zoom;
-      m_height = v;
+      const uint8_t *src = m_image_data_ptr->get_image();
+      size_t src_stride = m_image_data_ptr->get_stride();
+      uint8_t *dst;
+      size_t dst_stride;
+      size_t dst_pixel_size;
+      Data::PixelFormat format = m_image_data_ptr->get_pixel_format();
+      int full_width = m_image_data_ptr->get_width();
 
-      if (m_width <= m_window_width)
-        m_offset_x = 0;
+      if (m_surface)
+      {
+        if (m_is_surface_wrapped)
+          return;
+        dst = m_surface->get_data();
+        dst_stride = m_surface->get_stride();
+        dst_pixel_size = 4;
+      }
       else
       {
-        if (prev_width <= m_window_width)
-          v = -1 * (m_window_width - prev_width) / 2.0;
-        else
-          v = 0;
-        v = (in_x + m_offset_x + v) / prev_zoom;
-        v = v * m_zoom - in_x;
-        m_offset_x = v;
-        m_offset_x_max = m_width - m_window_width;
-        if (m_offset_x > m_offset_x_max)
-          m_offset_x = m_offset_x_max;
-        if (m_offset_x < 0)
-          m_offset_x = 0;
+        dst = m_pixbuf->get_pixels();
+        dst_stride = m_pixbuf->get_rowstride();
+        dst_pixel_size = 3;
       }
-      configure_h_adjustment(); // calling here is important
+      // The chroma samples are shared by 2 pixels
+      if (format == Data::PIXEL_FORMAT_YUYV || format == Data::PIXEL_FORMAT_UYVY ||
+          format == Data::PIXEL_FORMAT_NV12 || format == Data::PIXEL_FORMAT_I420)
+      {
+        in_x_start &= ~1;
+        in_x_end = std::min(full_width, (in_x_end + 1) & ~1);
+      }
+      if (format == Data::PIXEL_FORMAT_BAYER_RG8 || format == Data::PIXEL_FORMAT_BAYER_GB8 ||
+          format == Data::PIXEL_FORMAT_BAYER_GR8 || format == Data::PIXEL_FORMAT_BAYER_BG8)
+      {
+        in_x_start = 0;
+        in_x_end = full_width;
+      }
+      int width = in_x_end - in_x_start;
 
-      if (m_height <= m_window_height)
-        m_offset_y = 0;
-      else
+      src += in_y_start * src_stride + in_x_start * Data::get_bytes_per_pixel(format);
+      dst += in_y_start * dst_stride + in_x_start * dst_pixel_size;
+      switch (format)
       {
-        if (prev_height <= m_window_height)
-          v = -1 * (m_window_height - prev_height) / 2.0;
-        else
-          v = 0;
-        v = (in_y + m_offset_y + v) / prev_zoom;
-        v = v * m_zoom - in_y;
-        m_offset_y = v;
-        m_offset_y_max = m_height - m_window_height;
-        if (m_offset_y > m_offset_y_max)
-          m_offset_y = m_offset_y_max;
-        if (m_offset_y < 0)
-          m_offset_y = 0;
+        case Data::PIXEL_FORMAT_MONO8:
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::mono8_lut_to_rgb(src, dst, width, m_colormap32);
+          break;
+        case Data::PIXEL_FORMAT_MONO16:
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::mono16_to_rgb((const uint16_t *)src, dst, width,
+                                     m_mono16_lut.data(), m_colormap);
+          break;
+        case Data::PIXEL_FORMAT_MONO32F:
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::mono32f_to_rgb((const float *)src, dst, width,
+                                      m_float_min, m_float_max, m_colormap);
+          break;
+        case Data::PIXEL_FORMAT_RGB8:
+          if (src_stride == dst_stride && width == full_width && in_y_end > in_y_start)
+          {
+            // The last row of the pixbuf is not padded
+            ::memcpy(dst, src, (in_y_end - in_y_start - 1) * dst_stride + width * 3);
+            break;
+          }
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            ::memcpy(dst, src, width * 3);
+          break;
+        case Data::PIXEL_FORMAT_BGRA8:
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::bgra_to_rgb24(src, dst, width);
+          break;
+        case Data::PIXEL_FORMAT_RGBA8:
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::rgba_to_rgb24(src, dst, width);
+          break;
+        case Data::PIXEL_FORMAT_BGR8:
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::bgr_to_rgb24(src, dst, width);
+          break;
+        case Data::PIXEL_FORMAT_YUYV:
+        case Data::PIXEL_FORMAT_UYVY:
+        {
+          bool is_uyvy = (format == Data::PIXEL_FORMAT_UYVY);
+          const Converter::YUVCoefficients &coeffs = Converter::get_yuv_coefficients(
+                  m_image_data_ptr->get_yuv_matrix() == Data::YUV_MATRIX_BT709);
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::yuv422_to_rgb24(src, dst, width, is_uyvy, coeffs);
+          break;
+        }
+        case Data::PIXEL_FORMAT_NV12:
+        case Data::PIXEL_FORMAT_I420:
+        {
+          const Converter::YUVCoefficients &coeffs = Converter::get_yuv_coefficients(
+                  m_image_data_ptr->get_yuv_matrix() == Data::YUV_MATRIX_BT709);
+          bool is_nv12 = (format == Data::PIXEL_FORMAT_NV12);
+          size_t uv_step = is_nv12 ? 2 : 1;
+          const uint8_t *u_plane = m_image_data_ptr->get_plane(1) + (in_x_start / 2) * uv_step;
+          const uint8_t *v_plane = is_nv12 ? u_plane + 1 :
+                                   m_image_data_ptr->get_plane(2) + in_x_start / 2;
+          size_t u_stride = m_image_data_ptr->get_plane_stride(1);
+          size_t v_stride = is_nv12 ? u_stride : m_image_data_ptr->get_plane_stride(2);
+          for (int y = in_y_start; y < in_y_end; y++, src += src_stride, dst += dst_stride)
+            Converter::yuv420_to_rgb24(src, u_plane + (y / 2) * u_stride,
+                                       v_plane + (y / 2) * v_stride, uv_step,
+                                       dst, width, coeffs);
+          break;
+        }
+        case Data::PIXEL_FORMAT_BAYER_RG8:
+        case Data::PIXEL_FORMAT_BAYER_GB8:
+        case Data::PIXEL_FORMAT_BAYER_GR8:
+        case Data::PIXEL_FORMAT_BAYER_BG8:
+        {
+          int r_x, r_y;
+          int height = m_image_data_ptr->get_height();
+          Data::get_bayer_red_position(format, &r_x, &r_y);
+          src = m_image_data_ptr->get_image();
+          if (m_image_data_ptr->get_demosaic_mode() == Data::DEMOSAIC_NEAREST)
+          {
+            for (int y = in_y_start; y < in_y_end; y++, dst += dst_stride)
+              Converter::bayer_nearest_to_rgb(src, src_stride, width, height, y,
+                                              r_x, r_y, dst);
+          }
+          else
+          {
+            for (int y = in_y_start; y < in_y_end; y++, dst += dst_stride)
+              Converter::bayer_bilinear_to_rgb(src, src_stride, width, height, y,
+                                               r_x, r_y, dst);
+          }
+          break;
+        }
+        default:
+          break;
       }
-      configure_v_adjustment();
-      queue_draw();
-      invoke_zoom_updated_handlers();
     }
     // -------------------------------------------------------------------------
-    // update_pixbuf
+    // get_zoomed_image
     // -------------------------------------------------------------------------
-    bool update_pixbuf()
-    {
-      if (m_image_data_ptr == nullptr)
-        return false;
-      if (m_image_data_ptr->is_valid() == false)
-        return false;
-      bool need_to_create = true;
-      if (m_pixbuf)
+    // Returns the visible part of the image (within the clip of in_cr)
+    // expanded for the zoom (>= 1) by the nearest neighbour. Only the source
+    // pixels shown are read, and the rows showing the same source row are
+    // copied. The integer zoom factors replicate the pixels directly. The
+    // result is placed at (m_zoomed_x_start, m_zoomed_y_start) of the widget
+    // and kept while the image, the zoom and the position are not changed
+    //
+    Cairo::RefPtr<Cairo::ImageSurface> get_zoomed_image(const Cairo::RefPtr<Cairo::Context> &in_cr,
+                                                        const Cairo::RefPtr<Cairo::ImageSurface> &in_surface,
+                                                        const Glib::RefPtr<Gdk::Pixbuf> &in_pixbuf,
+                                                        double in_x, double in_y)
+    {
+      const uint8_t *src;
+      size_t src_stride, src_pixel_size;
+      int src_width, src_height;
+      if (in_surface)
       {
-        if (m_pixbuf->get_width() == m_image_data_ptr->get_width() &&
-            m_pixbuf->get_height() == m_image_data_ptr->get_height())
-          need_to_create = false;
+        in_surface->flush();
+        src = in_surface->get_data();
+        src_stride = in_surface->get_stride();
+        src_pixel_size = 4;
+        src_width = in_surface->get_width();
+        src_height = in_surface->get_height();
       }
-      if (need_to_create)
+      else if (in_pixbuf)
       {
-        m_org_width = m_image_data_ptr->get_width();
-        m_org_height = m_image_data_ptr->get_height();
-        m_width = m_org_width;
-        m_height = m_org_height;
-        configure_h_adjustment();
-        configure_v_adjustment();
-        m_pixbuf = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, false, 8,
-                                       m_image_data_ptr->get_width(),
-                                       m_image_data_ptr->get_height());
-        if (!m_pixbuf)
-          return false;
-        invoke_image_info_updated_handlers();
-      } else
+        src = in_pixbuf->get_pixels();
+        src_stride = in_pixbuf->get_rowstride();
+        src_pixel_size = 3;
+        src_width = in_pixbuf->get_width();
+        src_height = in_pixbuf->get_height();
+      }
+      else
+        return Cairo::RefPtr<Cairo::ImageSurface>();
+      // The widget pixels whose centers are on the image (and in the clip)
+      double clip_x0, clip_y0, clip_x1, clip_y1;
+      in_cr->get_clip_extents(clip_x0, clip_y0, clip_x1, clip_y1);
+      int x0 = std::max((int )floor(clip_x0), (int )ceil(in_x - 0.5));
+      int y0 = std::max((int )floor(clip_y0), (int )ceil(in_y - 0.5));
+      int x1 = std::min((int )ceil(clip_x1), (int )ceil(in_x + src_width * m_zoom - 0.5));
+      int y1 = std::min((int )ceil(clip_y1), (int )ceil(in_y + src_height * m_zoom - 0.5));
+      double zoom = m_zoom;
+      int integer_zoom = (int )floor(zoom + 0.5);
+      bool is_integer_zoom = (fabs(zoom - integer_zoom) < 1e-9 && integer_zoom >= 1);
+      int src_x_start = 0, phase = 0;
+      if (is_integer_zoom && x0 < x1)
       {
-        if (m_image_data_ptr->is_modified() == false)
-          return true;
+        double c = x0 + 0.5 - in_x;
+        src_x_start = std::max(0, (int )floor(c / integer_zoom));
+        phase = std::min(std::max((int )floor(c - src_x_start * integer_zoom), 0), integer_zoom - 1);
+        // The replication must not run past the right edge
+        x1 = std::min(x1, x0 + (src_width - src_x_start) * integer_zoom - phase);
       }
-      if (m_image_data_ptr->get_frame_counter() == 0)
+      if (x0 >= x1 || y0 >= y1)
+        return Cairo::RefPtr<Cairo::ImageSurface>();
+      if (m_is_zoomed_image_valid && m_zoomed_source == src &&
+          m_zoomed_zoom == m_zoom && m_zoomed_origin_x == in_x && m_zoomed_origin_y == in_y &&
+          x0 >= m_zoomed_x_start && y0 >= m_zoomed_y_start &&
+          x1 <= m_zoomed_x_end && y1 <= m_zoomed_y_end)
+        return m_zoomed_image;
+      int width = x1 - x0;
+      int height = y1 - y0;
+      if (!m_zoomed_image ||
+          m_zoomed_image->get_width() != width || m_zoomed_image->get_height() != height)
       {
-        m_fps_counter.start_count();
-        m_fps = 0;
-        m_fps_sum_counter.start_count();
-        m_fps_sum = 0;
-        m_fps_sum_num = 0;
+        m_zoomed_image = Cairo::ImageSurface::create(Cairo::FORMAT_RGB24, width, height);
+        if (!m_zoomed_image)
+          return m_zoomed_image;
       }
-      else
+      m_zoomed_image->flush();
+      uint8_t *dst = m_zoomed_image->get_data();
+      size_t dst_stride = m_zoomed_image->get_stride();
+      // The source column of each destination column
+      if (is_integer_zoom == false)
       {
-        double v;
-        v = (double )m_fps_counter.elapsed_time();
-        m_fps_counter.start_count();
-        if (v != 0)
-          v = 1000000000.0 / v;
-        m_fps_sum += v;
-        m_fps_sum_num++;
-        if (m_fps_sum_counter.elapsed_time() > 1000000000)
+        m_zoomed_x_index.resize(width);
+        for (int i = 0; i < width; i++)
         {
-          m_fps = m_fps_sum / m_fps_sum_num;
-          m_fps_sum_counter.start_count();
-          m_fps_sum = 0;
-          m_fps_sum_num = 0;
+          int sx = (int )floor((x0 + i + 0.5 - in_x) / zoom);
+          m_zoomed_x_index[i] = std::min(std::max(sx, 0), src_width - 1);
         }
+        src_x_start = m_zoomed_x_index[0];
+        for (int i = 0; i < width; i++)
+          m_zoomed_x_index[i] -= src_x_start;
       }
-      update_mouse_info();
-      invoke_frame_info_updated_handlers(true, m_fps);
-      if (m_image_data_ptr->is_mono())
-      {
-        if (m_colormap_index != m_image_data_ptr->get_colormap_index())
-        {
-          m_colormap_index = m_image_data_ptr->get_colormap_index();
-          Colormap::get_colormap(m_colormap_index, IM_VIEW_COLORMAP_COLOR_NUM,
-                                 m_colormap);
-        }
-        size_t data_size = m_image_data_ptr->get_buffer_size();
-        uint8_t *src = m_image_data_ptr->get_image();
-        uint8_t *dst = m_pixbuf->get_pixels();
-        for (int i = 0; i < data_size; i++)
-        {
-          size_t index = *src * 3;
-          src++;
-          //
-          *dst = m_colormap[index];
-          dst++;
-          index++;
-          *dst = m_colormap[index];
-          dst++;
-          index++;
-          *dst = m_colormap[index];
-          dst++;
-        }
-      } else
+      const int *x_index = m_zoomed_x_index.data();
+      run_row_bands(0, height, width,
+                    [&, x_index, width](int in_y0, int in_y1)
       {
-        ::memcpy(m_pixbuf->get_pixels(),
-                 m_image_data_ptr->get_image(),
-                 m_image_data_ptr->get_buffer_size());
-      }
-      m_image_data_ptr->clear_modified_flag();
-      return true;
+        int prev_sy = -1;
+        for (int y = in_y0; y < in_y1; y++)
+        {
+          uint8_t *row = dst + y * dst_stride;
+          int sy = (int )floor((y0 + y + 0.5 - in_y) / zoom);
+          sy = std::min(std::max(sy, 0), src_height - 1);
+          if (sy == prev_sy)
+          {
+            ::memcpy(row, row - dst_stride, (size_t )width * 4);
+            continue;
+          }
+          const uint8_t *src_row = src + sy * src_stride + src_x_start * src_pixel_size;
+          if (is_integer_zoom)
+            Converter::expand_row_integer(src_row, src_pixel_size, integer_zoom, phase, row, width);
+          else
+            Converter::expand_row_nearest(src_row, src_pixel_size, x_index, row, width);
+          prev_sy = sy;
+        }
+      });
+      m_zoomed_image->mark_dirty();
+      m_is_zoomed_image_valid = true;
+      m_zoomed_source = src;
+      m_zoomed_zoom = m_zoom;
+      m_zoomed_origin_x = in_x;
+      m_zoomed_origin_y = in_y;
+      m_zoomed_x_start = x0;
+      m_zoomed_y_start = y0;
+      m_zoomed_x_end = x1;
+      m_zoomed_y_end = y1;
+      return m_zoomed_image;
+    }
+    // -------------------------------------------------------------------------
+    // invalidate_zoomed_image
+    // -------------------------------------------------------------------------
+    void invalidate_zoomed_image()
+    {
+      m_is_zoomed_image_valid = false;
     }
     // -------------------------------------------------------------------------
     // on_draw
@@ -2558,30 +8020,79 @@ namespace image     // shl::gtk::image
         return false;
       //
       double x, y;
-      if (m_width <= m_window_width)
-        x = (m_window_width - m_width) / 2;
-      else
-        x = -1 * m_offset_x;
-      if (m_height <= m_window_height)
-        y = (m_window_height - m_height) / 2;
-      else
-        y = -1 * m_offset_y;
+      get_image_position(&x, &y);
+      m_is_drawn_origin_valid = true;
+      m_drawn_origin_x = x;
+      m_drawn_origin_y = y;
+      m_drawn_zoom = m_zoom;
       //
-      if (m_zoom >= 1)
+      Cairo::RefPtr<Cairo::ImageSurface> surface = m_surface;
+      Glib::RefPtr<Gdk::Pixbuf> pixbuf = m_pixbuf;
+      Cairo::RefPtr<Cairo::ImageSurface> scaled, zoomed;
+      bool is_rescale_pending = false;
+      if (m_image_data_ptr->is_async_conversion_enabled())
+      {
+        // Paints the last finished conversion only
+        surface = m_presented_surface;
+        pixbuf = m_presented_pixbuf;
+        if (m_zoom < 1)
+        {
+          // The full size image is never painted on the UI thread : the
+          // previous scaled image is stretched until the rescale lands
+          if (!m_presented_scaled_image)
+            return false;
+          scaled = m_presented_scaled_image;
+          is_rescale_pending = (is_presented_scaled_valid() == false);
+        }
+      }
+      else if (m_zoom < 1)
+        scaled = get_scaled_image(m_zoom);
+      if (!scaled && !surface && !pixbuf)
+        return false;
+      // FILTER_GOOD until the image is resampled for the new zoom (< 1)
+      Cairo::Filter filter = Cairo::Filter::FILTER_NEAREST;
+      if (m_zoom < 1)
+        filter = Cairo::Filter::FILTER_GOOD;
+      if (is_rescale_pending)
       {
-        //cr->set_identity_matrix();
         cr->translate(x, y);
-        cr->scale(m_zoom, m_zoom);
-        Gdk::Cairo::set_source_pixbuf(cr, m_pixbuf, 0, 0);
+        cr->scale(m_org_width * m_zoom / scaled->get_width(),
+                  m_org_height * m_zoom / scaled->get_height());
+        cr->set_source(scaled, 0, 0);
+        Cairo::SurfacePattern pattern(cr->get_source()->cobj());
+        pattern.set_filter(filter);
+      } else if (scaled)
+      {
+        // Already in the display size : drawn 1:1 at the pixel boundary
+        cr->set_source(scaled, floor(x + 0.5), floor(y + 0.5));
         Cairo::SurfacePattern pattern(cr->get_source()->cobj());
         pattern.set_filter(Cairo::Filter::FILTER_NEAREST);
+      } else if (m_zoom >= 1 && (zoomed = get_zoomed_image(cr, surface, pixbuf, x, y)))
+      {
+        // Already expanded for the visible area : drawn 1:1
+        cr->set_source(zoomed, m_zoomed_x_start, m_zoomed_y_start);
+        Cairo::SurfacePattern pattern(cr->get_source()->cobj());
+        pattern.set_filter(Cairo::Filter::FILTER_NEAREST);
+      } else if (surface)
+      {
+        cr->translate(x, y);
+        cr->scale(m_zoom, m_zoom);
+        cr->set_source(surface, 0, 0);
+        Cairo::SurfacePattern pattern(cr->get_source()->cobj());
+        pattern.set_filter(filter);
+      } else if (m_zoom < 1)
+      {
+        // No scaled image (yet) : set_source_pixbuf() would allocate and
+        // convert the whole pixbuf on every draw
+        return false;
       } else
       {
-        Gdk::Cairo::set_source_pixbuf(cr,
-                                      m_pixbuf->scale_simple(
-                                              (int) m_width, (int) m_height,
-                                              Gdk::INTERP_NEAREST),
-                                      x, y);
+        //cr->set_identity_matrix();
+        cr->translate(x, y);
+        cr->scale(m_zoom, m_zoom);
+        Gdk::Cairo::set_source_pixbuf(cr, pixbuf, 0, 0);
+        Cairo::SurfacePattern pattern(cr->get_source()->cobj());
+        pattern.set_filter(filter);
       }
       cr->paint();
       return true;
@@ -2621,6 +8132,8 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     void on_unrealize() override
     {
+      stop_frame_tick();
+      m_is_drawn_origin_valid = false;
       m_window.reset();
 
       //Call base class:
@@ -2631,6 +8144,22 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     bool on_button_press_event(GdkEventButton *button_event) override
     {
+      // Right button : drag to adjust the window/level, double-click to reset
+      if (button_event->button == 3)
+      {
+        if (button_event->type == GDK_2BUTTON_PRESS)
+        {
+          m_mouse_r_pressed = false;
+          reset_window_level();
+          return true;
+        }
+        m_mouse_r_pressed = get_window_level(&m_window_org, &m_level_org);
+        if (m_window_org <= 0)  // e.g. the auto-range of a flat MONO32F frame
+          m_window_org = 1.0;
+        m_mouse_x = button_event->x;
+        m_mouse_y = button_event->y;
+        return true;
+      }
       m_mouse_l_pressed = true;
       m_mouse_x = button_event->x;
       m_mouse_y = button_event->y;
@@ -2645,6 +8174,17 @@ namespace image     // shl::gtk::image
     {
       update_mouse_info(motion_event->x, motion_event->y);
       //
+      if (m_mouse_r_pressed)
+      {
+        // Right : widens the window (x2 / IM_VIEW_WINDOW_LEVEL_DRAG_STEP pixels)
+        // Down : raises the level (+window / IM_VIEW_WINDOW_LEVEL_DRAG_STEP pixels)
+        double window = m_window_org;
+        double level = m_level_org +
+                (motion_event->y - m_mouse_y) * window / IM_VIEW_WINDOW_LEVEL_DRAG_STEP;
+        window *= pow(2.0, (motion_event->x - m_mouse_x) / IM_VIEW_WINDOW_LEVEL_DRAG_STEP);
+        set_window_level(window, level);
+        return true;
+      }
       if (m_mouse_l_pressed == false)
         return false;
 
@@ -2702,6 +8242,11 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     bool on_button_release_event(GdkEventButton *release_event) override
     {
+      if (release_event->button == 3)
+      {
+        m_mouse_r_pressed = false;
+        return true;
+      }
       m_mouse_l_pressed = false;
       return true;
     }
@@ -2864,6 +8409,38 @@ namespace image     // shl::gtk::image
         m_offset_y = v->get_value();
       }
       m_adjustments_modified = false;
+      scroll_view();
+    }
+    // -------------------------------------------------------------------------
+    // scroll_view
+    // -------------------------------------------------------------------------
+    // Panning of the unchanged frame : moves the pixels already drawn in the
+    // window (copied by the windowing system, no pixel is sent for the
+    // remote displays) and redraws only the newly exposed strips. The other
+    // cases (a new frame, the zoom change, the fractional move and so on) are
+    // redrawn entirely
+    //
+    void scroll_view()
+    {
+      double x, y;
+      get_image_position(&x, &y);
+      double dx = x - m_drawn_origin_x;
+      double dy = y - m_drawn_origin_y;
+      if (dx == 0 && dy == 0)
+        return;
+      if (m_window && m_is_drawn_origin_valid && m_drawn_zoom == m_zoom &&
+          dx == floor(dx) && dy == floor(dy) &&
+          fabs(dx) < m_window_width && fabs(dy) < m_window_height &&
+          m_is_async_job_posted == false &&
+          m_image_data_ptr != nullptr &&
+          m_image_data_ptr->is_modified() == false &&
+          m_image_data_ptr->is_new_frame_pending() == false)
+      {
+        m_window->scroll((int )dx, (int )dy);
+        m_drawn_origin_x = x;
+        m_drawn_origin_y = y;
+        return;
+      }
       queue_draw();
     }
     // -------------------------------------------------------------------------
@@ -2887,9 +8464,22 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     bool save_pixbuf(const std::string &in_filename, const Glib::ustring &in_type)
     {
+      if (m_is_async_job_posted)
+        present_async_result();
+      if (m_pixbuf || m_surface)
+      {
+        convert_whole_image();
+        invalidate_zoomed_image();
+      }
+      Glib::RefPtr<Gdk::Pixbuf> pixbuf = m_pixbuf;
+      if (!pixbuf && m_surface)
+        pixbuf = Gdk::Pixbuf::create(m_surface, 0, 0,
+                                     m_surface->get_width(), m_surface->get_height());
+      if (!pixbuf)
+        return false;
       try
       {
-        m_pixbuf->save(in_filename, in_type);
+        pixbuf->save(in_filename, in_type);
       }
       catch (Glib::FileError &ex)
       {
@@ -2915,7 +8505,10 @@ namespace image     // shl::gtk::image
       FILE *fp = fopen(in_filename.c_str(), "wb");
       if (fp == nullptr)
         return false;
-      fwrite(image, sizeof(uint8_t), size, fp);
+      // The planes of the planar formats are not always contiguous
+      for (int i = 0; i < Data::get_plane_num(m_image_data_ptr->get_pixel_format()); i++)
+        fwrite(m_image_data_ptr->get_plane(i), sizeof(uint8_t),
+               m_image_data_ptr->get_plane_stride(i) * m_image_data_ptr->get_plane_height(i), fp);
       fclose(fp);
       return true;
     }
@@ -2934,14 +8527,22 @@ namespace image     // shl::gtk::image
     {
       for (auto handler : m_update_handlers)
       {
-        if (m_image_data_ptr == nullptr || !m_pixbuf)
+        if (m_image_data_ptr == nullptr || (!m_pixbuf && !m_surface))
+        {
+          handler->view_image_format_updated(false, Data::PIXEL_FORMAT_NOT_SPECIFIED);
           handler->view_image_info_updated(false, 0, 0, false);
+        }
         else
+        {
+          handler->view_image_format_updated(
+                  m_image_data_ptr->is_valid(),
+                  m_image_data_ptr->get_pixel_format());
           handler->view_image_info_updated(
                   m_image_data_ptr->is_valid(),
                   m_image_data_ptr->get_width(),
                   m_image_data_ptr->get_height(),
                   m_image_data_ptr->is_mono());
+        }
       }
     }
     // -------------------------------------------------------------------------
@@ -2950,14 +8551,35 @@ namespace image     // shl::gtk::image
     void invoke_mouse_info_updated_handlers(bool in_is_valid_mouse_info,
                                             int in_mouse_x, int in_mouse_y,
                                             bool in_is_mouse_mono,
-                                            int in_mouse_r, int in_mouse_g, int in_mouse_b)
+                                            double in_mouse_r, double in_mouse_g, double in_mouse_b)
     {
       for (auto handler : m_update_handlers)
-        handler->view_mouse_info_updated(
+      {
+        handler->view_mouse_value_updated(
                 in_is_valid_mouse_info,
                 in_mouse_x, in_mouse_y,
                 in_is_mouse_mono,
                 in_mouse_r, in_mouse_g, in_mouse_b);
+        handler->view_mouse_info_updated(
+                in_is_valid_mouse_info,
+                in_mouse_x, in_mouse_y,
+                in_is_mouse_mono,
+                Data::to_pixel_int(in_mouse_r),
+                Data::to_pixel_int(in_mouse_g),
+                Data::to_pixel_int(in_mouse_b));
+      }
+    }
+    // -------------------------------------------------------------------------
+    // invoke_window_level_updated_handlers
+    // -------------------------------------------------------------------------
+    void invoke_window_level_updated_handlers()
+    {
+      double window = 0, level = 0;
+      bool is_overridden = false;
+      if (m_image_data_ptr != nullptr)
+        is_overridden = m_image_data_ptr->get_display_window_level(&window, &level);
+      for (auto handler : m_update_handlers)
+        handler->view_window_level_updated(is_overridden, window, level);
     }
     // -------------------------------------------------------------------------
     // invoke_frame_info_updated_handlers
@@ -2966,12 +8588,19 @@ namespace image     // shl::gtk::image
     {
       for (auto handler : m_update_handlers)
       {
-        if (m_image_data_ptr == nullptr || !m_pixbuf)
+        if (m_image_data_ptr == nullptr || (!m_pixbuf && !m_surface))
+        {
+          handler->view_frame_stats_updated(0, 0);
           handler->view_frame_info_updated(false, 0, 0);
+        }
         else
+        {
+          handler->view_frame_stats_updated(m_image_data_ptr->get_produced_frame_num(),
+                                            m_image_data_ptr->get_displayed_frame_num());
           handler->view_frame_info_updated(in_is_valid_frame_info,
                                            m_image_data_ptr->get_frame_counter(),
                                            in_fps);
+        }
       }
     }
     // -------------------------------------------------------------------------
@@ -3019,11 +8648,25 @@ namespace image     // shl::gtk::image
         y = (int )t;
       }
 
-      bool is_mono;
-      int pix_r, pix_g, pix_b;
-      if (m_image_data_ptr->get_pixel_value(x, y,
-              &is_mono, &pix_r, &pix_g, &pix_b) == false)
-        is_valid = false;
+      // The int version is the one the subclasses override. MONO32F is read
+      // without truncation (it has no int representation to override)
+      bool is_mono = false;
+      double pix_r = 0, pix_g = 0, pix_b = 0;
+      if (m_image_data_ptr->get_pixel_format() == Data::PIXEL_FORMAT_MONO32F)
+      {
+        if (m_image_data_ptr->get_pixel_value_double(x, y,
+                &is_mono, &pix_r, &pix_g, &pix_b) == false)
+          is_valid = false;
+      }
+      else
+      {
+        int r = 0, g = 0, b = 0;
+        if (m_image_data_ptr->get_pixel_value(x, y, &is_mono, &r, &g, &b) == false)
+          is_valid = false;
+        pix_r = r;
+        pix_g = g;
+        pix_b = b;
+      }
       //
       m_mouse_info_x = in_mouse_x;
       m_mouse_info_y = in_mouse_y;
@@ -3054,6 +8697,8 @@ namespace image     // shl::gtk::image
     double m_zoom;
     bool m_zoom_best_fit;
     bool m_mouse_l_pressed;
+    bool m_mouse_r_pressed;
+    double m_window_org, m_level_org;
     bool m_adjustments_modified;
 
     PerfCounter m_fps_counter;
@@ -3064,12 +8709,53 @@ namespace image     // shl::gtk::image
 
     Data *m_image_data_ptr;
     bool m_is_image_size_changed;
+    Data::PixelFormat m_pixel_format;
 
     Colormap::ColormapIndex m_colormap_index;
-    uint8_t m_colormap[IM_VIEW_COLORMAP_DATA_SIZE] = {};
+    Colormap::ColormapLUT m_colormap_lut;
+    const uint8_t *m_colormap;
+    uint32_t m_colormap32[IM_VIEW_COLORMAP_COLOR_NUM] = {};
+    bool m_is_colormap32_valid;
+    int m_mono8_lut_window;
+    int m_mono8_lut_level;
+    std::vector<uint8_t> m_mono16_lut;
+    int m_mono16_lut_window;
+    int m_mono16_lut_level;
+    double m_float_min, m_float_max;
+    double m_presented_float_min, m_presented_float_max;
+    int m_converted_x_start, m_converted_y_start;
+    int m_converted_x_end, m_converted_y_end;
 
     Glib::RefPtr<Gdk::Window> m_window;
     Glib::RefPtr<Gdk::Pixbuf> m_pixbuf;
+    Cairo::RefPtr<Cairo::ImageSurface> m_surface;
+    bool m_is_surface_wrapped;
+    std::vector<Cairo::RefPtr<Cairo::ImageSurface>> m_mipmaps;
+    Cairo::RefPtr<Cairo::ImageSurface> m_scaled_image;
+    int m_scaled_level;
+    Converter::AreaWeights m_scaled_weights_x, m_scaled_weights_y;
+    std::vector<Data::Region> m_modified_regions;
+    std::vector<Data::Region> m_queued_regions;
+    base::TaskThread m_conversion_thread;
+    Glib::Dispatcher m_async_dispatcher;
+    bool m_is_async_job_posted;
+    guint m_frame_tick_id;
+    Glib::RefPtr<Gdk::Pixbuf> m_presented_pixbuf;
+    Glib::RefPtr<Gdk::Pixbuf> m_spare_pixbuf;
+    Cairo::RefPtr<Cairo::ImageSurface> m_presented_surface;
+    Cairo::RefPtr<Cairo::ImageSurface> m_spare_surface;
+    Cairo::RefPtr<Cairo::ImageSurface> m_presented_scaled_image;
+    Cairo::RefPtr<Cairo::ImageSurface> m_zoomed_image;
+    bool m_is_zoomed_image_valid;
+    const uint8_t *m_zoomed_source;
+    double m_zoomed_zoom;
+    double m_zoomed_origin_x, m_zoomed_origin_y;
+    int m_zoomed_x_start, m_zoomed_y_start;
+    int m_zoomed_x_end, m_zoomed_y_end;
+    std::vector<int> m_zoomed_x_index;
+    bool m_is_drawn_origin_valid;
+    double m_drawn_origin_x, m_drawn_origin_y;
+    double m_drawn_zoom;
 
     std::vector<UpdateHandlerInterface *>  m_update_handlers;
 
@@ -3312,20 +8998,39 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     void view_image_info_updated(bool in_is_valid_image_info,
                                 int in_image_width, int in_image_height,
-                                bool in_is_image_mono) override
+                                bool /* in_is_image_mono */) override
     {
       if (m_image_view.get_image_data() == nullptr)
         return;
       update_status_left(in_is_valid_image_info, in_image_width, in_image_height,
-                         in_is_image_mono, m_image_view.get_zoom());
+                         m_status_image_format_pending, m_image_view.get_zoom());
+    }
+    // -------------------------------------------------------------------------
+    // view_image_format_updated
+    // -------------------------------------------------------------------------
+    void view_image_format_updated(bool /* in_is_valid_image_info */,
+                                   Data::PixelFormat in_image_format) override
+    {
+      m_status_image_format_pending = in_image_format;
     }
     // -------------------------------------------------------------------------
     // view_mouse_info_updated
     // -------------------------------------------------------------------------
-    void view_mouse_info_updated(bool in_is_valid_mouse_info,
-                                int in_mouse_x, int in_mouse_y,
-                                bool in_is_mouse_mono,
-                                int in_mouse_r, int in_mouse_g, int in_mouse_b) override
+    void view_mouse_info_updated(bool /* in_is_valid_mouse_info */,
+                                int /* in_mouse_x */, int /* in_mouse_y */,
+                                bool /* in_is_mouse_mono */,
+                                int /* in_mouse_r */, int /* in_mouse_g */,
+                                int /* in_mouse_b */) override
+    {
+      // Displayed by view_mouse_value_updated() (called just before)
+    }
+    // -------------------------------------------------------------------------
+    // view_mouse_value_updated
+    // -------------------------------------------------------------------------
+    void view_mouse_value_updated(bool in_is_valid_mouse_info,
+                                  int in_mouse_x, int in_mouse_y,
+                                  bool in_is_mouse_mono,
+                                  double in_mouse_r, double in_mouse_g, double in_mouse_b) override
     {
       update_status_center(in_is_valid_mouse_info,
                            in_mouse_x, in_mouse_y,
@@ -3338,7 +9043,34 @@ namespace image     // shl::gtk::image
     void view_frame_info_updated(bool in_is_valid_frame_info,
                                 unsigned in_frame_count, double in_fps) override
     {
-      update_status_right(in_is_valid_frame_info, in_frame_count, in_fps);
+      update_status_right(in_is_valid_frame_info, in_frame_count, in_fps,
+                          m_status_dropped_num_pending);
+    }
+    // -------------------------------------------------------------------------
+    // view_frame_stats_updated
+    // -------------------------------------------------------------------------
+    void view_frame_stats_updated(uint64_t in_produced_num, uint64_t in_displayed_num) override
+    {
+      m_status_dropped_num_pending = 0;
+      if (in_produced_num > in_displayed_num)
+        m_status_dropped_num_pending = in_produced_num - in_displayed_num;
+    }
+    // -------------------------------------------------------------------------
+    // view_window_level_updated
+    // -------------------------------------------------------------------------
+    void view_window_level_updated(bool in_is_overridden,
+                                   double in_window, double in_level) override
+    {
+      m_status_is_window_level = in_is_overridden;
+      m_status_window = in_window;
+      m_status_level = in_level;
+      if (m_image_view.get_image_data() == nullptr)
+        return;
+      update_status_left(m_image_view.get_image_data()->is_valid(),
+                         m_image_view.get_image_data()->get_width(),
+                         m_image_view.get_image_data()->get_height(),
+                         m_image_view.get_image_data()->get_pixel_format(),
+                         m_image_view.get_zoom(), true);
     }
     // -------------------------------------------------------------------------
     // MainWindow constructor
@@ -3350,6 +9082,11 @@ namespace image     // shl::gtk::image
             m_status_box(Gtk::Orientation::ORIENTATION_HORIZONTAL, 0)
     {
       m_file_save_index = 0;
+      m_status_image_format_pending = Data::PIXEL_FORMAT_NOT_SPECIFIED;
+      m_status_dropped_num_pending = 0;
+      m_status_is_window_level = false;
+      m_status_window = 0;
+      m_status_level = 0;
       //
       m_zoom_out_button.set_image_from_icon_name("zoom-out-symbolic");
       m_zoom_out_button.signal_clicked().connect(
@@ -3416,9 +9153,9 @@ namespace image     // shl::gtk::image
       m_header.pack_start(m_header_left_box);
       m_header.pack_end(m_header_right_box);
       //
-      update_status_left(false, 0, 0, false, 0, true);
+      update_status_left(false, 0, 0, Data::PIXEL_FORMAT_NOT_SPECIFIED, 0, true);
       update_status_center(false, 0, 0, false, 0, 0, 0, true);
-      update_status_right(false, 0, 0, true);
+      update_status_right(false, 0, 0, 0, true);
       m_status_left.set_alignment(Gtk::ALIGN_START, Gtk::ALIGN_FILL);
       m_status_center.set_alignment(Gtk::ALIGN_CENTER, Gtk::ALIGN_FILL);
       m_status_right.set_alignment(Gtk::ALIGN_END, Gtk::ALIGN_FILL);
@@ -3451,7 +9188,7 @@ namespace image     // shl::gtk::image
     void update()
     {
       //m_image_view.update_widget();
-      m_image_view.queue_draw();
+      m_image_view.queue_draw_modified();
     }
 
   private:
@@ -3487,18 +9224,24 @@ namespace image     // shl::gtk::image
     bool m_status_is_valid_image_info;
     int m_status_image_width;
     int m_status_image_height;
-    bool m_status_is_image_mono;
+    Data::PixelFormat m_status_image_format;
     double m_status_image_zoom;
+    Data::PixelFormat m_status_image_format_pending;
+    uint64_t m_status_dropped_num_pending;
+    bool m_status_is_window_level;
+    double m_status_window;
+    double m_status_level;
     bool m_status_is_valid_mouse_info;
     int m_status_mouse_x;
     int m_status_mouse_y;
     bool m_status_is_mouse_mono;
-    int m_status_mouse_r;
-    int m_status_mouse_g;
-    int m_status_mouse_b;
+    double m_status_mouse_r;
+    double m_status_mouse_g;
+    double m_status_mouse_b;
     bool m_is_status_valid_frame_info;
     unsigned int m_status_frame_count;
     double m_status_image_fps;
+    uint64_t m_status_dropped_num;
 
     friend class shl::gtk::ImageWindow;
 
@@ -3513,7 +9256,7 @@ namespace image     // shl::gtk::image
       update_status_left(m_image_view.get_image_data()->is_valid(),
                          m_image_view.get_image_data()->get_width(),
                          m_image_view.get_image_data()->get_height(),
-                         m_image_view.get_image_data()->is_mono(),
+                         m_image_view.get_image_data()->get_pixel_format(),
                          m_image_view.get_zoom());
     }
     // -------------------------------------------------------------------------
@@ -3521,7 +9264,7 @@ namespace image     // shl::gtk::image
     // -------------------------------------------------------------------------
     void update_status_left(bool in_is_valid_image_info,
                             int in_image_width, int in_image_height,
-                            bool in_is_image_mono, double in_image_zoom,
+                            Data::PixelFormat in_image_format, double in_image_zoom,
                             bool in_force_update = false)
     {
       if (in_is_valid_image_info == false &&
@@ -3533,7 +9276,7 @@ namespace image     // shl::gtk::image
       if (m_status_is_valid_image_info == in_is_valid_image_info &&
           m_status_image_width == in_image_width &&
           m_status_image_height == in_image_height &&
-          m_status_is_image_mono == in_is_image_mono &&
+          m_status_image_format == in_image_format &&
           m_status_image_zoom == in_image_zoom &&
           in_force_update == false)
       {
@@ -3542,14 +9285,10 @@ namespace image     // shl::gtk::image
       m_status_is_valid_image_info = in_is_valid_image_info;
       m_status_image_width = in_image_width;
       m_status_image_height = in_image_height;
-      m_status_is_image_mono = in_is_image_mono;
+      m_status_image_format = in_image_format;
       m_status_image_zoom = in_image_zoom;
 
       char buf[256];
-      const char *formatStr[] = {"RGB8", "MONO8"};
-      int formatIndex = 0;
-      if (in_is_image_mono)
-        formatIndex = 1;
       if (m_status_is_valid_image_info == false)
       {
         buf[0] = 0;
@@ -3557,10 +9296,16 @@ namespace image     // shl::gtk::image
       else
       {
         sprintf(buf, "%s  %d x %d pixels %d%%",
-                formatStr[formatIndex],
+                Data::get_pixel_format_name(m_status_image_format),
                 m_status_image_width,
                 m_status_image_height,
                 (int) (m_status_image_zoom * 100.0));
+        if (m_status_is_window_level)
+        {
+          size_t len = strlen(buf);
+          snprintf(buf + len, sizeof(buf) - len, "  W/L %g/%g",
+                   m_status_window, m_status_level);
+        }
       }
       m_status_left.set_text(buf);
     }
@@ -3570,7 +9315,7 @@ namespace image     // shl::gtk::image
     void update_status_center(bool in_is_valid_mouse_info,
             int in_mouse_x, int in_mouse_y,
             bool in_is_mouse_mono,
-            int in_mouse_r, int in_mouse_g, int in_mouse_b,
+            double in_mouse_r, double in_mouse_g, double in_mouse_b,
             bool in_force_update = false)
     {
       if (in_is_valid_mouse_info == false &&
@@ -3582,7 +9327,7 @@ namespace image     // shl::gtk::image
       if (m_status_is_valid_mouse_info == in_is_valid_mouse_info &&
           m_status_mouse_x == in_mouse_x &&
           m_status_mouse_y == in_mouse_y &&
-          m_status_is_image_mono == in_is_mouse_mono &&
+          m_status_is_mouse_mono == in_is_mouse_mono &&
           m_status_mouse_r == in_mouse_r &&
           m_status_mouse_g == in_mouse_g &&
           m_status_mouse_b == in_mouse_b &&
@@ -3593,7 +9338,7 @@ namespace image     // shl::gtk::image
       m_status_is_valid_mouse_info = in_is_valid_mouse_info;
       m_status_mouse_x = in_mouse_x;
       m_status_mouse_y = in_mouse_y;
-      m_status_is_image_mono = in_is_mouse_mono;
+      m_status_is_mouse_mono = in_is_mouse_mono;
       m_status_mouse_r = in_mouse_r;
       m_status_mouse_g = in_mouse_g;
       m_status_mouse_b = in_mouse_b;
@@ -3605,16 +9350,16 @@ namespace image     // shl::gtk::image
       }
       else
       {
-        if (m_status_is_image_mono)
+        if (m_status_is_mouse_mono)
         {
-          sprintf(buf, "[%d,%d] = %d",
+          sprintf(buf, "[%d,%d] = %g",
                   m_status_mouse_x,
                   m_status_mouse_y,
                   m_status_mouse_r);
         }
         else
         {
-          sprintf(buf, "[%d,%d] = %d,%d,%d",
+          sprintf(buf, "[%d,%d] = %g,%g,%g",
                   m_status_mouse_x,
                   m_status_mouse_y,
                   m_status_mouse_r,
@@ -3628,7 +9373,7 @@ namespace image     // shl::gtk::image
     // update_status_right
     // -------------------------------------------------------------------------
     void update_status_right(bool in_is_valid_frame_info,
-            unsigned int in_frame_count, double in_fps,
+            unsigned int in_frame_count, double in_fps, uint64_t in_dropped_num,
             bool in_force_update = false)
     {
       if (in_is_valid_frame_info == false &&
@@ -3640,6 +9385,7 @@ namespace image     // shl::gtk::image
       if (m_is_status_valid_frame_info == in_is_valid_frame_info &&
           m_status_frame_count == in_frame_count &&
           m_status_image_fps == in_fps &&
+          m_status_dropped_num == in_dropped_num &&
           in_force_update == false)
       {
         return;
@@ -3647,6 +9393,7 @@ namespace image     // shl::gtk::image
       m_is_status_valid_frame_info = in_is_valid_frame_info;
       m_status_frame_count = in_frame_count;
       m_status_image_fps = in_fps;
+      m_status_dropped_num = in_dropped_num;
 
       char buf[256];
       if (m_is_status_valid_frame_info == false)
@@ -3655,9 +9402,15 @@ namespace image     // shl::gtk::image
       }
       else
       {
-        sprintf(buf, "%d    %.2ffps",
-                m_status_frame_count,
-                m_status_image_fps);
+        if (m_status_dropped_num == 0)
+          sprintf(buf, "%d    %.2ffps",
+                  m_status_frame_count,
+                  m_status_image_fps);
+        else
+          sprintf(buf, "%d    %.2ffps    %llu dropped",
+                  m_status_frame_count,
+                  m_status_image_fps,
+                  (unsigned long long )m_status_dropped_num);
       }
       m_status_right.set_text(buf);
     }
@@ -3747,10 +9500,34 @@ namespace image     // shl::gtk::image
       if (m_window == nullptr)
         return;
       // The following will call WindowData::update() at the end of the call chain
-      mark_as_modified();
+      // (the published frame marks itself as modified in the triple buffer mode,
+      // and the regions marked by mark_region_modified() are kept)
+      // The produced frame was counted by set_external_buffer(),
+      // submit_buffer(), mark_as_modified() etc., so only the frame counter
+      // is updated here
+      if (is_triple_buffer_enabled() == false && is_partially_modified() == false)
+      {
+        mark_as_modified(true);
+        increment_frame_counter();
+      }
       m_window->update();
     }
 
+    // -------------------------------------------------------------------------
+    // update_window_by_frame_clock
+    // -------------------------------------------------------------------------
+    // In the frame clock pacing mode the view polls the modified flag on each
+    // frame of the display, so nothing is posted once the polling is running.
+    // m_window is not touched here (it is deleted on the UI thread)
+    //
+    bool update_window_by_frame_clock() override
+    {
+      if (is_frame_clock_pacing_enabled() == false)
+        return false;
+      return mark_for_frame_tick(is_triple_buffer_enabled() == false &&
+                                 is_partially_modified() == false);
+    }
+
   private:
     shl::gtk::image::MainWindow *m_window;
   };
@@ -0,0 +1,104 @@
+// =============================================================================
+//  frame_stats_check.cpp
+//
+//  Checks the produced / displayed frame statistics of shl::gtk::ImageWindow.
+//  Each frame is set by set_external_buffer() or submit_buffer() followed by
+//  update(), and the check waits until the frame is displayed. One frame has to be counted as
+//  exactly one produced frame, so that no frame is reported as dropped.
+//  The exit status is non-zero on a mismatch (a display is needed).
+//
+//  Build (from the repository root):
+//    g++ -std=c++17 -O2 -I. bench/frame_stats_check.cpp -o frame_stats_check
+//        $(pkg-config --cflags --libs gtkmm-3.0) -lpthread
+//  Usage:
+//    ./frame_stats_check [frames]
+// =============================================================================
+#include "ImageWindowGTK.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using shl::gtk::image::Data;
+
+// -----------------------------------------------------------------------------
+// wait_displayed
+// -----------------------------------------------------------------------------
+// Waits until the view has displayed all of the produced frames (1 sec max)
+//
+static void wait_displayed(shl::gtk::ImageWindow *in_window)
+{
+  auto start = std::chrono::steady_clock::now();
+  while (in_window->get_displayed_frame_num() != in_window->get_produced_frame_num() &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(1))
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+// -----------------------------------------------------------------------------
+// check_frame_stats
+// -----------------------------------------------------------------------------
+// Returns false (and reports the numbers) if the statistics after in_frame_num
+// frames are not in_frame_num produced and displayed frames
+//
+static bool check_frame_stats(shl::gtk::ImageWindow *in_window, const char *in_name,
+                              uint64_t in_frame_num)
+{
+  uint64_t produced = in_window->get_produced_frame_num();
+  uint64_t displayed = in_window->get_displayed_frame_num();
+  bool result = (produced == in_frame_num && displayed == in_frame_num);
+  printf("%-20s frames %llu, produced %llu, displayed %llu : %s\n", in_name,
+         (unsigned long long )in_frame_num, (unsigned long long )produced,
+         (unsigned long long )displayed, result ? "OK" : "MISMATCH");
+  return result;
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  const int width = 640, height = 480;
+  int frame_num = 30;
+  if (argc >= 2)
+    frame_num = atoi(argv[1]);
+  if (frame_num <= 0)
+  {
+    printf("usage: %s [frames]\n", argv[0]);
+    return 1;
+  }
+
+  shl::gtk::ImageWindow window;
+  std::vector<uint8_t> buffers[2];
+  for (auto &buffer : buffers)
+    buffer.resize((size_t )width * height);
+  window.set_external_buffer(buffers[0].data(), width, height, Data::PIXEL_FORMAT_MONO8);
+  window.show_window("frame_stats_check");
+  wait_displayed(&window);
+  window.reset_frame_statistics();
+
+  for (int i = 0; i < frame_num; i++)
+  {
+    std::vector<uint8_t> &buffer = buffers[i % 2];
+    std::fill(buffer.begin(), buffer.end(), (uint8_t )(i * 8));
+    window.set_external_buffer(buffer.data(), width, height, Data::PIXEL_FORMAT_MONO8);
+    window.update();
+    wait_displayed(&window);
+  }
+  bool result = check_frame_stats(&window, "set_external_buffer", frame_num);
+
+  window.reset_frame_statistics();
+  for (int i = 0; i < frame_num; i++)
+  {
+    std::shared_ptr<uint8_t> buffer(new uint8_t[(size_t )width * height],
+                                    std::default_delete<uint8_t[]>());
+    std::fill(buffer.get(), buffer.get() + (size_t )width * height, (uint8_t )(i * 8));
+    window.submit_buffer(buffer, width, height, Data::PIXEL_FORMAT_MONO8);
+    window.update();
+    wait_displayed(&window);
+  }
+  if (check_frame_stats(&window, "submit_buffer", frame_num) == false)
+    result = false;
+  return result ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+// =============================================================================
+//  mono8_lut_bench.cpp
+//
+//  Compares the MONO8 -> RGB8 colormap expansion kernels of
+//  shl::gtk::image::Converter with the original per-pixel loop
+//  (Converter::mono8_to_rgb). The outputs are checked to be byte-identical
+//  for all the lengths around the SIMD block sizes before timing.
+//
+//  Build (from the repository root):
+//    g++ -std=c++17 -O2 -I. bench/mono8_lut_bench.cpp -o mono8_lut_bench
+//        $(pkg-config --cflags --libs gtkmm-3.0) -lpthread
+//  Usage:
+//    ./mono8_lut_bench [width height [iterations]]
+// =============================================================================
+#include "ImageWindowGTK.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using shl::gtk::image::Converter;
+
+// -----------------------------------------------------------------------------
+// Kernels - exposes the per-ISA kernels (protected in Converter)
+// -----------------------------------------------------------------------------
+struct Kernels : Converter
+{
+#ifdef SHL_IMAGE_USE_RUNTIME_DISPATCH
+  using Converter::mono8_lut_to_rgb_sse41;
+  using Converter::mono8_lut_to_rgb_avx2;
+#endif
+};
+
+typedef void (*KernelFunc)(const uint8_t *in_src, uint8_t *out_dst, size_t in_num,
+                           const uint8_t *in_colormap, const uint32_t *in_lut32);
+
+struct KernelEntry
+{
+  const char *name;
+  bool supported;
+  KernelFunc func;
+};
+
+// -----------------------------------------------------------------------------
+// get_kernels
+// -----------------------------------------------------------------------------
+static std::vector<KernelEntry> get_kernels()
+{
+  std::vector<KernelEntry> kernels;
+  kernels.push_back({"loop", true,
+                     [](const uint8_t *s, uint8_t *d, size_t n, const uint8_t *cm, const uint32_t *)
+                     { Converter::mono8_to_rgb(s, d, n, cm); }});
+  kernels.push_back({"scalar", true,
+                     [](const uint8_t *s, uint8_t *d, size_t n, const uint8_t *, const uint32_t *lut)
+                     { Converter::mono8_lut_to_rgb_scalar(s, d, n, lut); }});
+#ifdef SHL_IMAGE_USE_RUNTIME_DISPATCH
+  __builtin_cpu_init();
+  kernels.push_back({"sse4.1", (bool )__builtin_cpu_supports("sse4.1"),
+                     [](const uint8_t *s, uint8_t *d, size_t n, const uint8_t *, const uint32_t *lut)
+                     { Kernels::mono8_lut_to_rgb_sse41(s, d, n, lut); }});
+  kernels.push_back({"avx2", (bool )__builtin_cpu_supports("avx2"),
+                     [](const uint8_t *s, uint8_t *d, size_t n, const uint8_t *, const uint32_t *lut)
+                     { Kernels::mono8_lut_to_rgb_avx2(s, d, n, lut); }});
+#endif
+  kernels.push_back({"dispatch", true,
+                     [](const uint8_t *s, uint8_t *d, size_t n, const uint8_t *, const uint32_t *lut)
+                     { Converter::mono8_lut_to_rgb(s, d, n, lut); }});
+  return kernels;
+}
+
+// -----------------------------------------------------------------------------
+// check_kernels
+// -----------------------------------------------------------------------------
+// Returns the number of the kernels whose output differs from the loop
+// (the bytes after the row are checked to be untouched as well)
+//
+static int check_kernels(const std::vector<KernelEntry> &in_kernels,
+                         const uint8_t *in_colormap, const uint32_t *in_lut32)
+{
+  const size_t guard = 64;
+  int error_num = 0;
+  for (const auto &kernel : in_kernels)
+  {
+    if (kernel.supported == false)
+      continue;
+    for (size_t num = 0; num <= 300; num++)
+    {
+      std::vector<uint8_t> src(num);
+      for (auto &v : src)
+        v = (uint8_t )rand();
+      std::vector<uint8_t> expected(num * 3 + guard, 0xA5);
+      std::vector<uint8_t> result(num * 3 + guard, 0xA5);
+      Converter::mono8_to_rgb(src.data(), expected.data(), num, in_colormap);
+      kernel.func(src.data(), result.data(), num, in_colormap, in_lut32);
+      if (result != expected)
+      {
+        printf("%-8s differs from the loop (num = %zu)\n", kernel.name, num);
+        error_num++;
+        break;
+      }
+    }
+  }
+  return error_num;
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  int width = 2592, height = 1944, iteration_num = 50;
+  if (argc >= 3)
+  {
+    width = atoi(argv[1]);
+    height = atoi(argv[2]);
+  }
+  if (argc >= 4)
+    iteration_num = atoi(argv[3]);
+  if (width <= 0 || height <= 0 || iteration_num <= 0)
+  {
+    printf("usage: %s [width height [iterations]]\n", argv[0]);
+    return 1;
+  }
+
+  uint8_t colormap[256 * 3];
+  for (auto &v : colormap)
+    v = (uint8_t )rand();
+  uint32_t lut32[256];
+  Converter::make_rgb_lut32(colormap, lut32);
+
+  std::vector<KernelEntry> kernels = get_kernels();
+  int error_num = check_kernels(kernels, colormap, lut32);
+  printf("output check: %s\n", error_num == 0 ? "identical" : "MISMATCH");
+
+  std::vector<uint8_t> src((size_t )width * height);
+  std::vector<uint8_t> dst((size_t )width * height * 3);
+  for (auto &v : src)
+    v = (uint8_t )rand();
+
+  printf("%d x %d, %d iterations\n", width, height, iteration_num);
+  double loop_ms = 0;
+  for (const auto &kernel : kernels)
+  {
+    if (kernel.supported == false)
+    {
+      printf("%-8s (not supported by this CPU)\n", kernel.name);
+      continue;
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iteration_num; i++)
+      for (int y = 0; y < height; y++)
+        kernel.func(&src[(size_t )y * width], &dst[(size_t )y * width * 3], width,
+                    colormap, lut32);
+    double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count() / iteration_num;
+    if (loop_ms == 0)
+      loop_ms = ms;
+    printf("%-8s %8.3f ms/frame  x%.2f\n", kernel.name, ms, loop_ms / ms);
+  }
+  return error_num == 0 ? 0 : 1;
+}